@@ -0,0 +1,214 @@
+#ifndef MPVPROFILE_H
+#define MPVPROFILE_H
+
+// Named mpv option sets shared by all examples. A profile is picked with
+// --profile=<name>; --profile-file=<path> adds or replaces profiles from a
+// JSON ({"name": {"option": "value"}}) or INI ([name] option=value) file.
+// Header-only and C++11 so the Qt5 example can use it too.
+
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QStringList>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+struct MpvProfile
+{
+    typedef QPair<QByteArray, QByteArray> Option;
+
+    QByteArray name;
+    QList<Option> options;
+
+    // "name (option=value, ...)" for the startup report
+    QByteArray describe() const
+    {
+        QList<QByteArray> parts;
+        for (const Option& option : options)
+            parts.append(option.first + "=" + option.second);
+        return name + " (" + parts.join(", ") + ")";
+    }
+
+    // Command line form, for backends that spawn an mpv process
+    QStringList toArguments() const
+    {
+        QStringList args;
+        for (const Option& option : options)
+            args.append(QString::fromUtf8("--" + option.first + "=" + option.second));
+        return args;
+    }
+};
+
+typedef QMap<QByteArray, MpvProfile> MpvProfileSet;
+
+inline MpvProfile makeMpvProfile(const char* name, std::initializer_list<MpvProfile::Option> options)
+{
+    MpvProfile profile;
+    profile.name = name;
+    profile.options = options;
+    return profile;
+}
+
+inline MpvProfileSet builtinMpvProfiles()
+{
+    MpvProfileSet profiles;
+    // Verbose logs as the examples always had, mpv's defaults otherwise
+    profiles["default"] = makeMpvProfile("default", {
+        {"msg-level", "all=v"},
+    });
+    profiles["low-latency"] = makeMpvProfile("low-latency", {
+        {"msg-level", "all=warn"},
+        {"vd-lavc-threads", "1"},
+        {"video-sync", "audio"},
+        {"interpolation", "no"},
+        {"video-latency-hacks", "yes"},
+        {"cache", "no"},
+        {"demuxer-readahead-secs", "0.5"},
+        {"demuxer-lavf-analyzeduration", "0.1"},
+        {"audio-buffer", "0"},
+        {"scale", "bilinear"},
+    });
+    profiles["low-memory"] = makeMpvProfile("low-memory", {
+        {"msg-level", "all=warn"},
+        {"cache", "no"},
+        {"demuxer-max-bytes", "16MiB"},
+        {"demuxer-max-back-bytes", "0"},
+        {"vd-lavc-threads", "2"},
+        {"scale", "bilinear"},
+    });
+    profiles["max-quality"] = makeMpvProfile("max-quality", {
+        {"msg-level", "all=warn"},
+        {"demuxer-max-bytes", "512MiB"},
+        {"demuxer-max-back-bytes", "128MiB"},
+        {"vd-lavc-threads", "0"},
+        {"scale", "ewa_lanczossharp"},
+        {"cscale", "ewa_lanczossharp"},
+        {"dscale", "mitchell"},
+        {"deband", "yes"},
+        {"video-sync", "display-resample"},
+        {"interpolation", "yes"},
+        {"tscale", "oversample"},
+    });
+    profiles["battery"] = makeMpvProfile("battery", {
+        {"msg-level", "all=warn"},
+        {"hwdec", "auto-safe"},
+        {"demuxer-max-bytes", "64MiB"},
+        {"vd-lavc-threads", "2"},
+        {"scale", "bilinear"},
+        {"cscale", "bilinear"},
+        {"dscale", "bilinear"},
+        {"deband", "no"},
+        {"video-sync", "audio"},
+    });
+    return profiles;
+}
+
+// Adds the profiles in a JSON or INI file to `profiles`; false if unreadable.
+// JSON objects are unordered, so use INI when option order matters.
+inline bool loadMpvProfileFile(const QString& path, MpvProfileSet& profiles)
+{
+    if (QFileInfo(path).suffix().compare("json", Qt::CaseInsensitive) == 0) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+        QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+        if (!doc.isObject())
+            return false;
+        QJsonObject root = doc.object();
+        for (QJsonObject::const_iterator it = root.constBegin(); it != root.constEnd(); ++it) {
+            MpvProfile profile;
+            profile.name = it.key().toUtf8();
+            QJsonObject options = it.value().toObject();
+            for (QJsonObject::const_iterator opt = options.constBegin(); opt != options.constEnd(); ++opt) {
+                QJsonValue value = opt.value();
+                // Integers stay integers (536870912, not 5.36871e+08); other
+                // numbers keep full precision
+                double number = value.toDouble();
+                QByteArray text = value.isString() ? value.toString().toUtf8()
+                                : value.isBool() ? QByteArray(value.toBool() ? "yes" : "no")
+                                : std::fabs(number) < 9007199254740992.0 && number == std::floor(number)
+                                    ? QByteArray::number(qint64(number))
+                                : QByteArray::number(number, 'g', 17);
+                profile.options.append(MpvProfile::Option(opt.key().toUtf8(), text));
+            }
+            profiles[profile.name] = profile;
+        }
+        return true;
+    }
+
+    // Parsed by hand rather than with QSettings, which sorts keys; options
+    // apply in file order, and some mpv options depend on it
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+    QByteArray current;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith(';') || line.startsWith('#'))
+            continue;
+        if (line.startsWith('[') && line.endsWith(']')) {
+            current = line.mid(1, line.size() - 2).trimmed();
+            profiles[current] = MpvProfile();
+            profiles[current].name = current;
+            continue;
+        }
+        int eq = line.indexOf('=');
+        if (current.isEmpty() || eq <= 0)
+            return false;
+        QByteArray value = line.mid(eq + 1).trimmed();
+        if (value.size() >= 2 && value.startsWith('"') && value.endsWith('"'))
+            value = value.mid(1, value.size() - 2);
+        profiles[current].options.append(MpvProfile::Option(line.left(eq).trimmed(), value));
+    }
+    return true;
+}
+
+// Consumes --profile=<name> and --profile-file=<path> from argv so the
+// examples' positional arguments stay where they were. Exits on bad input.
+inline MpvProfile mpvProfileFromArguments(int& argc, char** argv)
+{
+    MpvProfileSet profiles = builtinMpvProfiles();
+    QByteArray name = "default";
+
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--profile=", 10) == 0) {
+            name = argv[i] + 10;
+        } else if (strncmp(argv[i], "--profile-file=", 15) == 0) {
+            if (!loadMpvProfileFile(QString::fromLocal8Bit(argv[i] + 15), profiles)) {
+                fprintf(stderr, "Could not read mpv profile file %s\n", argv[i] + 15);
+                exit(1);
+            }
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    argv[argc] = nullptr;
+
+    if (!profiles.contains(name)) {
+        fprintf(stderr, "Unknown mpv profile '%s'; available: %s\n", name.constData(),
+                profiles.keys().join(", ").constData());
+        exit(1);
+    }
+    return profiles[name];
+}
+
+// The profile main() selected; read by items that configure their own mpv
+inline MpvProfile& activeMpvProfile()
+{
+    static MpvProfile profile = builtinMpvProfiles()["default"];
+    return profile;
+}
+
+#endif // MPVPROFILE_H
@@ -0,0 +1,139 @@
+#ifndef MPVPROPERTYBATCHER_H
+#define MPVPROPERTYBATCHER_H
+
+// Throttled, batched delivery of observed mpv property changes, shared by the
+// Qt6 MpvItems. Changes arrive on mpv's event thread; the newest value of each
+// property is kept and flushed to the GUI thread at most once per display
+// frame, each property no more often than its own rate cap.
+// Header-only, no moc needed.
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <QScreen>
+#include <QTimer>
+#include <QVariantMap>
+
+#include <atomic>
+#include <functional>
+
+class MpvPropertyBatcher
+{
+public:
+    typedef std::function<void(const QVariantMap &changes)> Deliver;
+
+    // item is the GUI-thread owner (its screen sets the flush rate); deliver
+    // gets every batch of changes there
+    MpvPropertyBatcher(QQuickItem *item, Deliver deliver)
+        : m_item(item), m_deliver(std::move(deliver))
+    {
+        m_clock.start();
+        m_flushTimer.setSingleShot(true);
+        QObject::connect(&m_flushTimer, &QTimer::timeout, m_item, [this]() { flush(); });
+    }
+
+    // GUI thread. Sets the property's rate cap (0 = every GUI frame); returns
+    // true only the first time, when the caller must start observing it in mpv
+    bool observe(const QString &property, qreal maxRate)
+    {
+        bool added = !m_observations.contains(property);
+        m_observations[property].minIntervalMs = maxRate > 0 ? qRound64(1000.0 / maxRate) : 0;
+        return added;
+    }
+
+    // Latest delivered value of every observed property
+    const QVariantMap &observed() const { return m_observed; }
+
+    // mpv's event thread: keep only the newest value, post at most one flush
+    void propertyChanged(const QString &property, const QVariant &value)
+    {
+        {
+            QMutexLocker lock(&m_pendingMutex);
+            m_pending.insert(property, value);
+        }
+        if (!m_flushScheduled.exchange(true))
+            QMetaObject::invokeMethod(m_item, [this]() { flush(); }, Qt::QueuedConnection);
+    }
+
+private:
+    struct Observation {
+        qint64 minIntervalMs = 0;
+        qint64 lastDeliveredMs = -1;
+    };
+
+    qint64 frameIntervalMs() const
+    {
+        QScreen *screen = m_item->window() ? m_item->window()->screen() : nullptr;
+        qreal hz = screen ? screen->refreshRate() : 60;
+        return hz > 0 ? qMax<qint64>(1, qRound64(1000.0 / hz)) : 16;
+    }
+
+    void flush()
+    {
+        const qint64 now = m_clock.elapsed();
+        const qint64 frameMs = frameIntervalMs();
+        if (m_lastFlushMs >= 0 && now - m_lastFlushMs < frameMs) {
+            m_flushTimer.start(int(frameMs - (now - m_lastFlushMs)));
+            return;
+        }
+
+        QVariantMap pending;
+        {
+            QMutexLocker lock(&m_pendingMutex);
+            pending.swap(m_pending);
+            m_flushScheduled = false;
+        }
+
+        QVariantMap changes;
+        QVariantMap deferred;
+        qint64 nextDue = -1;
+        for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+            auto observation = m_observations.find(it.key());
+            if (observation == m_observations.end())
+                continue;
+            if (observation->lastDeliveredMs >= 0 && now - observation->lastDeliveredMs < observation->minIntervalMs) {
+                // Over its rate cap: hold the newest value until it is due
+                qint64 due = observation->lastDeliveredMs + observation->minIntervalMs;
+                nextDue = nextDue < 0 ? due : qMin(nextDue, due);
+                deferred.insert(it.key(), it.value());
+                continue;
+            }
+            observation->lastDeliveredMs = now;
+            changes.insert(it.key(), it.value());
+            m_observed.insert(it.key(), it.value());
+        }
+
+        if (!deferred.isEmpty()) {
+            QMutexLocker lock(&m_pendingMutex);
+            for (auto it = deferred.cbegin(); it != deferred.cend(); ++it) {
+                if (!m_pending.contains(it.key()))
+                    m_pending.insert(it.key(), it.value());
+            }
+            m_flushScheduled = true;
+            m_flushTimer.start(int(qMax(nextDue - now, frameMs)));
+        }
+
+        if (!changes.isEmpty()) {
+            m_lastFlushMs = now;
+            m_deliver(changes);
+        }
+    }
+
+    // GUI thread
+    QQuickItem *m_item;
+    Deliver m_deliver;
+    QHash<QString, Observation> m_observations;
+    QVariantMap m_observed;
+    QElapsedTimer m_clock;
+    QTimer m_flushTimer;
+    qint64 m_lastFlushMs = -1;
+
+    // Written from mpv's event thread, newest value per property
+    QMutex m_pendingMutex;
+    QVariantMap m_pending;
+    std::atomic<bool> m_flushScheduled{false};
+};
+
+#endif // MPVPROPERTYBATCHER_H
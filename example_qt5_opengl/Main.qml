@@ -23,6 +23,24 @@ Window {
         visible: false
     }
 
+    // Video wall: one MpvVideo per stream when several files or
+    // MPV_OVERLAY_WALL=N are given; all share the window's render scheduler
+    Grid {
+        id: wall
+        anchors.fill: parent
+        columns: Math.max(1, Math.ceil(Math.sqrt(wallStreams)))
+        readonly property int rows: Math.max(1, Math.ceil(wallStreams / columns))
+
+        Repeater {
+            model: wallStreams
+            MpvVideo {
+                objectName: "wall" + index
+                width: wall.width / wall.columns
+                height: wall.height / wall.rows
+            }
+        }
+    }
+
     // WebEngineView overlays on top of the MPV video
     WebEngineView {
         id: web
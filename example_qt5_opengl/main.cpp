@@ -5,15 +5,36 @@
 #include <QQuickWindow>
 #include <QOpenGLContext>
 #include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include <QOpenGLFramebufferObject>
+#include <QOffscreenSurface>
+#include <QSGSimpleTextureNode>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
 #include <QRunnable>
+#include <QVector>
+#include <QScreen>
+#include <QSocketNotifier>
 #include <QDebug>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QtWebEngine/QtWebEngine>
 #include <mpv/client.h>
 #include <mpv/render_gl.h>
+#include "mpvprofile.h"
+#include <atomic>
 #include <clocale>
 #include <cstdio>
+#include <memory>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// Started in main(); used to log time-to-first-frame
+static QElapsedTimer startupTimer;
+
+// MPV_OVERLAY_THREADED=1: mpv renders on its own thread instead of beforeRendering
+static bool threadedRendering = false;
 
 // Get OpenGL proc address for MPV
 static void* get_proc_address(void* ctx, const char* name)
@@ -24,27 +45,36 @@ static void* get_proc_address(void* ctx, const char* name)
     return (void*)glctx->getProcAddress(QByteArray(name));
 }
 
-// Render job to trigger window updates from render thread
-class RequestRepaintJob : public QRunnable
+// Frame accounting, written from mpv's thread and the render thread
+struct FrameStats
 {
-public:
-    explicit RequestRepaintJob(QQuickWindow* window) : m_window(window) {}
-    void run() override { m_window->update(); }
-private:
-    QQuickWindow* m_window;
+    std::atomic<qint64> updates{0};   // mpv update callbacks
+    std::atomic<qint64> repaints{0};  // repaints actually scheduled
+    std::atomic<qint64> rendered{0};  // frames with a new video frame
+    std::atomic<qint64> skipped{0};   // frames composited from the cache
+    std::atomic<qint64> dropped{0};   // frames consumed unrendered (offscreen or over the rate cap)
+    std::atomic<qint64> held{0};      // frames kept queued because their target time is after the next vsync
+    std::atomic<qint64> overlay{0};   // scene graph frames swapped
+
+    void frameRendered()
+    {
+        if (rendered++ == 0)
+            qDebug() << "First video frame after" << startupTimer.elapsed() << "ms";
+    }
 };
 
 // Forward declaration
 class PlayerQuickItem;
 
-// Renderer that draws MPV video to OpenGL framebuffer
+// Renderer that draws MPV video to OpenGL framebuffer; driven by RenderScheduler
 class PlayerRenderer : public QObject
 {
     Q_OBJECT
     friend class PlayerQuickItem;
+    friend class RenderScheduler;
 public:
-    PlayerRenderer(mpv_handle* mpv, QQuickWindow* window)
-        : m_mpv(mpv), m_mpvGL(nullptr), m_window(window), m_size()
+    PlayerRenderer(mpv_handle* mpv, QQuickWindow* window, PlayerQuickItem* item, FrameStats* stats)
+        : m_mpv(mpv), m_mpvGL(nullptr), m_window(window), m_item(item), m_stats(stats), m_size()
     {}
 
     bool init()
@@ -69,96 +99,587 @@ public:
 
     ~PlayerRenderer() override
     {
+        // Called from sceneGraphInvalidated, with the GL context still current
+        delete m_cache;
         if (m_mpvGL)
             mpv_render_context_free(m_mpvGL);
     }
 
-    void render()
+    // Consume mpv's pending frame: render it into the cache, or let mpv skip
+    // it when offscreen or over the rate cap. Overlay-only frames keep the cache.
+    void renderVideo()
     {
-        QOpenGLContext* context = QOpenGLContext::currentContext();
-        if (!context) return;
+        if (m_size.isEmpty()) return;
 
-        GLint fbo = 0;
-        context->functions()->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &fbo);
+        bool resized = false;
+        if (!m_cache || m_cache->size() != m_size) {
+            delete m_cache;
+            m_cache = new QOpenGLFramebufferObject(m_size);
+            resized = true;
+        }
+        bool newFrame = (mpv_render_context_update(m_mpvGL) & MPV_RENDER_UPDATE_FRAME) || m_framePending;
+        m_framePending = false;
+        if (!newFrame && !resized) {
+            m_stats->skipped++;
+            return;
+        }
 
-        m_window->resetOpenGLState();
+        // Target-time scheduling: a frame due after the next vsync stays queued
+        // in mpv while the cache keeps showing, and is rendered on a later frame
+        if (!resized && m_onscreen && dueAfterNextVsync()) {
+            m_framePending = true;
+            m_stats->held++;
+            requestRepaint();
+            return;
+        }
 
+        bool capped = m_maxFps > 0 && m_lastRender.isValid() && m_lastRender.elapsed() < 1000.0 / m_maxFps;
+        int skip = !m_onscreen || (capped && !resized);
         mpv_opengl_fbo mpv_fbo = {
-            fbo,
+            (int)m_cache->handle(),
             m_size.width(),
             m_size.height()
         };
         int flip = -1;
+        // Held frames are already scheduled by target time; mpv must not block on it too
+        int block = 0;
         mpv_render_param params[] = {
             {MPV_RENDER_PARAM_OPENGL_FBO, &mpv_fbo},
             {MPV_RENDER_PARAM_FLIP_Y, &flip},
+            {MPV_RENDER_PARAM_SKIP_RENDERING, &skip},
+            {MPV_RENDER_PARAM_BLOCK_FOR_TARGET_TIME, &block},
             {MPV_RENDER_PARAM_INVALID}
         };
         mpv_render_context_render(m_mpvGL, params);
-
         m_window->resetOpenGLState();
+        m_videoFrameRendered = true;
+
+        if (skip) {
+            m_stats->dropped++;
+            return;
+        }
+        m_lastRender.start();
+        m_stats->frameRendered();
+    }
+
+    bool dueAfterNextVsync()
+    {
+        mpv_render_frame_info info = {};
+        mpv_render_param param = {MPV_RENDER_PARAM_NEXT_FRAME_INFO, &info};
+        if (mpv_render_context_get_info(m_mpvGL, param) < 0)
+            return false;
+        if (!(info.flags & MPV_RENDER_FRAME_INFO_PRESENT) || (info.flags & MPV_RENDER_FRAME_INFO_REDRAW)
+            || info.target_time <= 0)
+            return false;
+        int64_t vsyncUs = int64_t(1e6 / m_displayFps);
+        return info.target_time - mpv_get_time_us(m_mpv) > vsyncUs;
+    }
+
+    // Blit the cached frame to the item's rect in Qt's framebuffer
+    void composite(QOpenGLExtraFunctions* gl, GLuint fbo)
+    {
+        if (!m_cache || !m_onscreen) return;
+        gl->glBindFramebuffer(GL_READ_FRAMEBUFFER, m_cache->handle());
+        gl->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+        gl->glBlitFramebuffer(0, 0, m_size.width(), m_size.height(),
+                              m_rect.left(), m_rect.top(), m_rect.right() + 1, m_rect.bottom() + 1,
+                              GL_COLOR_BUFFER_BIT, m_size == m_rect.size() ? GL_NEAREST : GL_LINEAR);
     }
 
     void swap()
     {
-        if (m_mpvGL)
+        // Only swaps that carried a new video frame count for mpv's timing
+        if (m_mpvGL && m_videoFrameRendered)
             mpv_render_context_report_swap(m_mpvGL);
+        m_videoFrameRendered = false;
     }
 
+    // Set during sync: target rect in framebuffer pixels (GL origin), render size
+    // after the item's resolution cap, visibility and rate cap
+    QRect m_rect;
     QSize m_size;
+    bool m_onscreen = true;
+    qreal m_maxFps = 0;
+    qreal m_displayFps = 60;
+
+private:
+    static void on_update(void* ctx);
+    void requestRepaint();
+
+    mpv_handle* m_mpv;
+    mpv_render_context* m_mpvGL;
+    QQuickWindow* m_window;
+    PlayerQuickItem* m_item;
+    FrameStats* m_stats;
+    QOpenGLFramebufferObject* m_cache = nullptr;
+    bool m_videoFrameRendered = false;
+    bool m_framePending = false;
+    QElapsedTimer m_lastRender;
+};
+
+// One per window: renders every registered mpv instance once per scene-graph
+// frame, then composites them all below the overlay in a single pass
+class RenderScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static RenderScheduler* forWindow(QQuickWindow* window)
+    {
+        RenderScheduler* scheduler = window->findChild<RenderScheduler*>(QString(), Qt::FindDirectChildrenOnly);
+        return scheduler ? scheduler : new RenderScheduler(window);
+    }
+
+    // Render thread only
+    void add(PlayerRenderer* renderer)
+    {
+        if (!m_renderers.contains(renderer))
+            m_renderers.append(renderer);
+    }
+
+    void remove(PlayerRenderer* renderer)
+    {
+        m_renderers.removeOne(renderer);
+    }
+
+private slots:
+    void renderFrame()
+    {
+        QOpenGLContext* context = QOpenGLContext::currentContext();
+        if (m_renderers.isEmpty() || !context) return;
+
+        QOpenGLExtraFunctions* gl = context->extraFunctions();
+        GLint fbo = 0;
+        gl->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &fbo);
+        m_window->resetOpenGLState();
+
+        for (PlayerRenderer* renderer : m_renderers)
+            renderer->renderVideo();
+
+        // Qt doesn't clear (the video is the background), so clear the gaps
+        gl->glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        gl->glClearColor(0, 0, 0, 1);
+        gl->glClear(GL_COLOR_BUFFER_BIT);
+        for (PlayerRenderer* renderer : m_renderers)
+            renderer->composite(gl, fbo);
+
+        m_window->resetOpenGLState();
+    }
+
+    void frameSwapped()
+    {
+        for (PlayerRenderer* renderer : m_renderers)
+            renderer->swap();
+    }
+
+private:
+    explicit RenderScheduler(QQuickWindow* window)
+        : QObject(window), m_window(window)
+    {
+        connect(window, &QQuickWindow::beforeRendering, this, &RenderScheduler::renderFrame, Qt::DirectConnection);
+        connect(window, &QQuickWindow::frameSwapped, this, &RenderScheduler::frameSwapped, Qt::DirectConnection);
+    }
+
+    QQuickWindow* m_window;
+    QVector<PlayerRenderer*> m_renderers;
+};
+
+// Drops a renderer on the render thread after its item left the window
+class ReleaseRendererJob : public QRunnable
+{
+public:
+    ReleaseRendererJob(RenderScheduler* scheduler, PlayerRenderer* renderer)
+        : m_scheduler(scheduler), m_renderer(renderer) {}
+    void run() override
+    {
+        m_scheduler->remove(m_renderer);
+        delete m_renderer;
+    }
+private:
+    RenderScheduler* m_scheduler;
+    PlayerRenderer* m_renderer;
+};
+
+// Threaded mode: mpv renders with its own shared GL context into a ring of
+// FBOs. Each finished frame is fenced; the scene graph samples the newest one
+// and fences it back when done, so neither side waits for the other's frame.
+class MpvRenderThread : public QThread
+{
+public:
+    MpvRenderThread(mpv_handle* mpv, PlayerQuickItem* item, FrameStats* stats, QOffscreenSurface* surface)
+        : m_mpv(mpv), m_item(item), m_stats(stats), m_surface(surface)
+    {}
+
+    ~MpvRenderThread() override
+    {
+        stop();
+    }
+
+    // Scene graph thread, Qt's context current: share it and start rendering
+    bool startRendering(QSize size)
+    {
+        QOpenGLContext* share = QOpenGLContext::currentContext();
+        m_context = new QOpenGLContext;
+        m_context->setFormat(share->format());
+        m_context->setShareContext(share);
+        if (!m_context->create()) {
+            delete m_context;
+            m_context = nullptr;
+            return false;
+        }
+        m_context->moveToThread(this);
+        m_size = size;
+        start();
+        return true;
+    }
+
+    void stop()
+    {
+        {
+            QMutexLocker lock(&m_mutex);
+            m_quit = true;
+            m_cond.wakeOne();
+        }
+        wait();
+    }
+
+    void setSize(QSize size)
+    {
+        QMutexLocker lock(&m_mutex);
+        if (size == m_size)
+            return;
+        m_size = size;
+        m_redraw = true;
+        m_cond.wakeOne();
+    }
+
+    // Scene graph thread, during sync: switch to the newest finished frame.
+    // Returns false if there is nothing newer than what is already shown.
+    bool acquireLatest(bool force, GLuint* texture, QSize* size)
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_latest < 0 || (m_latest == m_inUse && !force))
+            return false;
+        m_inUse = m_latest;
+        Slot& slot = m_slots[m_inUse];
+        QOpenGLContext::currentContext()->extraFunctions()->glWaitSync(slot.ready, 0, GL_TIMEOUT_IGNORED);
+        *texture = slot.fbo->texture();
+        *size = slot.fbo->size();
+        m_newFrameShown = true;
+        return true;
+    }
+
+    // Scene graph thread, after rendering: fence the texture Qt just sampled.
+    // Returns whether this frame showed a new video frame.
+    bool releaseFrame()
+    {
+        QMutexLocker lock(&m_mutex);
+        bool shown = m_newFrameShown;
+        m_newFrameShown = false;
+        if (m_inUse >= 0) {
+            QOpenGLExtraFunctions* gl = QOpenGLContext::currentContext()->extraFunctions();
+            Slot& slot = m_slots[m_inUse];
+            if (slot.released)
+                gl->glDeleteSync(slot.released);
+            slot.released = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        return shown;
+    }
+
+protected:
+    void run() override;
 
 private:
+    static const int RingSize = 3;
+
+    struct Slot
+    {
+        QOpenGLFramebufferObject* fbo = nullptr;
+        GLsync ready = nullptr;     // mpv finished rendering
+        GLsync released = nullptr;  // Qt finished sampling
+    };
+
     static void on_update(void* ctx)
     {
-        PlayerRenderer* self = (PlayerRenderer*)ctx;
-        if (self->thread() == self->m_window->thread())
-            QMetaObject::invokeMethod(self->m_window, "update", Qt::QueuedConnection);
-        else
-            self->m_window->scheduleRenderJob(new RequestRepaintJob(self->m_window), QQuickWindow::NoStage);
+        MpvRenderThread* self = (MpvRenderThread*)ctx;
+        self->m_stats->updates++;
+        QMutexLocker lock(&self->m_mutex);
+        self->m_updatePending = true;
+        self->m_cond.wakeOne();
     }
 
     mpv_handle* m_mpv;
-    mpv_render_context* m_mpvGL;
-    QQuickWindow* m_window;
+    mpv_render_context* m_mpvGL = nullptr;
+    PlayerQuickItem* m_item;
+    FrameStats* m_stats;
+    QOffscreenSurface* m_surface;
+    QOpenGLContext* m_context = nullptr;
+
+    // Guarded by m_mutex
+    QMutex m_mutex;
+    QWaitCondition m_cond;
+    QSize m_size;
+    bool m_updatePending = false;
+    bool m_redraw = false;
+    bool m_quit = false;
+    bool m_newFrameShown = false;
+    int m_latest = -1;  // newest finished slot
+    int m_inUse = -1;   // slot the scene graph samples
+    Slot m_slots[RingSize];
 };
 
 // QML item that hooks into rendering pipeline
 class PlayerQuickItem : public QQuickItem
 {
     Q_OBJECT
+    Q_PROPERTY(qint64 updatesReceived READ updatesReceived NOTIFY statsChanged)
+    Q_PROPERTY(qint64 repaintsScheduled READ repaintsScheduled NOTIFY statsChanged)
+    Q_PROPERTY(qint64 framesRendered READ framesRendered NOTIFY statsChanged)
+    Q_PROPERTY(qint64 framesSkipped READ framesSkipped NOTIFY statsChanged)
+    Q_PROPERTY(qint64 overlayFrames READ overlayFrames NOTIFY statsChanged)
+    Q_PROPERTY(qint64 framesDropped READ framesDropped NOTIFY statsChanged)
+    // Per-item caps for video walls: 0 means unlimited
+    Q_PROPERTY(qreal maxFps READ maxFps WRITE setMaxFps NOTIFY capsChanged)
+    Q_PROPERTY(int maxHeight READ maxHeight WRITE setMaxHeight NOTIFY capsChanged)
 public:
     explicit PlayerQuickItem(QQuickItem* parent = nullptr)
         : QQuickItem(parent), m_mpv(nullptr), m_renderer(nullptr)
     {
         connect(this, &QQuickItem::windowChanged, this, &PlayerQuickItem::onWindowChanged, Qt::DirectConnection);
+        if (threadedRendering)
+            setFlag(ItemHasContents);
+
+        // mpv wakeups reach the GUI thread through an eventfd: no per-update allocation
+        m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (m_wakeFd < 0)
+            qFatal("Could not create eventfd");
+        m_wakeNotifier = new QSocketNotifier(m_wakeFd, QSocketNotifier::Read, this);
+        connect(m_wakeNotifier, &QSocketNotifier::activated, this, &PlayerQuickItem::onRepaintWakeup);
+
+        // Periodically log mpv's view of display timing and publish frame stats
+        m_timingTimer.setInterval(5000);
+        connect(&m_timingTimer, &QTimer::timeout, this, &PlayerQuickItem::logDisplayTiming);
     }
 
     ~PlayerQuickItem() override
     {
         if (m_renderer && m_renderer->m_mpvGL)
             mpv_render_context_set_update_callback(m_renderer->m_mpvGL, nullptr, nullptr);
+        delete m_mpvThread;
+        delete m_offscreen;
+        delete m_wakeNotifier;
+        close(m_wakeFd);
+    }
+
+    // Called from mpv's thread; collapses bursts into one pending repaint
+    void scheduleRepaint()
+    {
+        m_stats.updates++;
+        requestRepaint();
+    }
+
+    // Any thread; at most one repaint is ever pending
+    void requestRepaint()
+    {
+        if (m_repaintPending.exchange(true))
+            return;
+        m_stats.repaints++;
+        uint64_t one = 1;
+        if (write(m_wakeFd, &one, sizeof(one)) < 0)
+            m_repaintPending = false;
+    }
+
+    qint64 updatesReceived() const { return m_stats.updates; }
+    qint64 repaintsScheduled() const { return m_stats.repaints; }
+    qint64 framesRendered() const { return m_stats.rendered; }
+    qint64 framesSkipped() const { return m_stats.skipped; }
+    qint64 overlayFrames() const { return m_stats.overlay; }
+    qint64 framesDropped() const { return m_stats.dropped; }
+
+    qreal maxFps() const { return m_maxFps; }
+    void setMaxFps(qreal fps)
+    {
+        if (qFuzzyCompare(fps, m_maxFps))
+            return;
+        m_maxFps = fps;
+        emit capsChanged();
+    }
+
+    int maxHeight() const { return m_maxHeight; }
+    void setMaxHeight(int height)
+    {
+        if (height == m_maxHeight)
+            return;
+        m_maxHeight = height;
+        emit capsChanged();
+        if (window())
+            window()->update();
     }
 
     void setMpvHandle(mpv_handle* mpv)
     {
         m_mpv = mpv;
+        updateDisplayFps();
+        m_timingTimer.start();
+        if (threadedRendering && window()) {
+            // The offscreen surface must be created on the GUI thread
+            m_offscreen = new QOffscreenSurface;
+            m_offscreen->setFormat(window()->requestedFormat());
+            m_offscreen->create();
+
+            // The video is a real scene graph node in this mode, below the overlay;
+            // the 0x0 background item grows to the window
+            if (isBackground()) {
+                QQuickWindow* win = window();
+                setVisible(true);
+                setSize(win->size());
+                connect(win, &QWindow::widthChanged, this, [this](int w) { setWidth(w); });
+                connect(win, &QWindow::heightChanged, this, [this](int h) { setHeight(h); });
+            }
+        }
         if (window())
             window()->update();
     }
 
+protected:
+    // Item left its window while the scene graph lives on
+    void releaseResources() override
+    {
+        if (m_renderer && window()) {
+            mpv_render_context_set_update_callback(m_renderer->m_mpvGL, nullptr, nullptr);
+            window()->scheduleRenderJob(new ReleaseRendererJob(m_scheduler, m_renderer),
+                                        QQuickWindow::BeforeSynchronizingStage);
+            m_renderer = nullptr;
+        }
+    }
+
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData*) override
+    {
+        QSGSimpleTextureNode* node = static_cast<QSGSimpleTextureNode*>(oldNode);
+        GLuint texture = 0;
+        QSize size;
+        if (!m_mpvThread || !m_mpvThread->acquireLatest(!node, &texture, &size))
+            return node;
+
+        if (!node) {
+            node = new QSGSimpleTextureNode;
+            node->setOwnsTexture(true);
+            // mpv renders bottom-up into the FBO (flip_y = 0)
+            node->setTextureCoordinatesTransform(QSGSimpleTextureNode::MirrorVertically);
+        }
+        if (!node->texture() || (GLuint)node->texture()->textureId() != texture || node->texture()->textureSize() != size)
+            node->setTexture(window()->createTextureFromId(texture, size));
+        node->setRect(boundingRect());
+        node->markDirty(QSGNode::DirtyMaterial);
+        return node;
+    }
+
+signals:
+    void statsChanged();
+    void capsChanged();
+    // Emitted from the rendering thread once mpv's render context exists
+    void rendererInitialized();
+
 private slots:
+    void onRepaintWakeup()
+    {
+        uint64_t count;
+        if (read(m_wakeFd, &count, sizeof(count)) < 0)
+            return;
+        // Clear before update() so an update during this frame schedules another
+        m_repaintPending = false;
+        if (threadedRendering)
+            update();
+        else if (window())
+            window()->update();
+    }
+
     void onWindowChanged(QQuickWindow* win)
     {
         if (win) {
+            m_scheduler = RenderScheduler::forWindow(win);
             connect(win, &QQuickWindow::beforeSynchronizing, this, &PlayerQuickItem::onSynchronize, Qt::DirectConnection);
             connect(win, &QQuickWindow::sceneGraphInvalidated, this, &PlayerQuickItem::onInvalidate, Qt::DirectConnection);
+            connect(win, &QQuickWindow::frameSwapped, this, &PlayerQuickItem::onFrameSwapped, Qt::DirectConnection);
+            connect(win, &QWindow::screenChanged, this, &PlayerQuickItem::onScreenChanged);
+            onScreenChanged(win->screen());
         }
     }
 
+    // Keep mpv's display-fps-override in sync with the screen the window is on
+    void onScreenChanged(QScreen* screen)
+    {
+        disconnect(m_screenConnection);
+        if (screen)
+            m_screenConnection = connect(screen, &QScreen::refreshRateChanged, this, &PlayerQuickItem::updateDisplayFps);
+        updateDisplayFps();
+    }
+
+    void updateDisplayFps()
+    {
+        if (!m_mpv || !window() || !window()->screen())
+            return;
+        qreal hz = window()->screen()->refreshRate();
+        if (hz <= 0 || qAbs(hz - m_displayFps) < 0.005)
+            return;
+        m_displayFps = hz;
+        QByteArray value = QByteArray::number(hz, 'f', 3);
+        mpv_set_property_string(m_mpv, "display-fps-override", value.constData());
+        qDebug() << "display-fps-override" << value;
+    }
+
+    void logDisplayTiming()
+    {
+        if (!m_mpv)
+            return;
+        double jitter = 0;
+        int64_t mistimed = 0, delayed = 0;
+        mpv_get_property(m_mpv, "vsync-jitter", MPV_FORMAT_DOUBLE, &jitter);
+        mpv_get_property(m_mpv, "mistimed-frame-count", MPV_FORMAT_INT64, &mistimed);
+        mpv_get_property(m_mpv, "vo-delayed-frame-count", MPV_FORMAT_INT64, &delayed);
+        qDebug("mpv timing: display-fps %.3f, vsync-jitter %.4f, mistimed %lld, vo-delayed %lld",
+               m_displayFps, jitter, (long long)mistimed, (long long)delayed);
+        qDebug("frames: updates %lld, repaints %lld, rendered %lld, skipped %lld, dropped %lld, held %lld, overlay %lld",
+               (long long)m_stats.updates, (long long)m_stats.repaints, (long long)m_stats.rendered,
+               (long long)m_stats.skipped, (long long)m_stats.dropped, (long long)m_stats.held,
+               (long long)m_stats.overlay);
+        emit statsChanged();
+    }
+
+    void onFrameSwapped()
+    {
+        m_stats.overlay++;
+    }
+
+    void onAfterRendering()
+    {
+        if (m_mpvThread && !m_mpvThread->releaseFrame())
+            m_stats.skipped++;
+    }
+
     void onSynchronize()
     {
+        if (threadedRendering) {
+            QSize size = (QSizeF(width(), height()) * window()->devicePixelRatio()).toSize();
+            if (!m_mpvThread && m_mpv && m_offscreen) {
+                m_mpvThread = new MpvRenderThread(m_mpv, this, &m_stats, m_offscreen);
+                if (!m_mpvThread->startRendering(size)) {
+                    delete m_mpvThread;
+                    m_mpvThread = nullptr;
+                    qFatal("Could not create shared OpenGL context");
+                    return;
+                }
+                connect(window(), &QQuickWindow::afterRendering, this, &PlayerQuickItem::onAfterRendering,
+                        static_cast<Qt::ConnectionType>(Qt::DirectConnection | Qt::UniqueConnection));
+                window()->setPersistentOpenGLContext(true);
+                window()->setPersistentSceneGraph(true);
+            }
+            if (m_mpvThread)
+                m_mpvThread->setSize(cappedSize(size));
+            return;
+        }
+
         if (!m_renderer && m_mpv) {
-            m_renderer = new PlayerRenderer(m_mpv, window());
+            m_renderer = new PlayerRenderer(m_mpv, window(), this, &m_stats);
             if (!m_renderer->init()) {
                 delete m_renderer;
                 m_renderer = nullptr;
@@ -166,70 +687,330 @@ private slots:
                 return;
             }
 
-            // Hook into rendering pipeline
-            connect(window(), &QQuickWindow::beforeRendering, m_renderer, &PlayerRenderer::render, Qt::DirectConnection);
-            connect(window(), &QQuickWindow::frameSwapped, m_renderer, &PlayerRenderer::swap, Qt::DirectConnection);
+            // Hook into rendering pipeline; the window's scheduler renders all items
+            m_scheduler->add(m_renderer);
 
             // Critical settings for overlay technique
             window()->setPersistentOpenGLContext(true);
             window()->setPersistentSceneGraph(true);
             window()->setClearBeforeRendering(false);  // Don't clear - video renders to background
+
+            emit rendererInitialized();
         }
 
         if (m_renderer) {
-            m_renderer->m_size = window()->size() * window()->devicePixelRatio();
+            // The 0x0 background item covers the whole window; wall items their own rect
+            QQuickWindow* win = window();
+            qreal dpr = win->devicePixelRatio();
+            QRectF scene = isBackground() ? QRectF(QPointF(0, 0), win->size()) : mapRectToScene(boundingRect());
+            QRect rect(qRound(scene.x() * dpr), qRound((win->height() - scene.bottom()) * dpr),
+                       qRound(scene.width() * dpr), qRound(scene.height() * dpr));
+            QRect windowRect(QPoint(0, 0), win->size() * dpr);
+            m_renderer->m_rect = rect;
+            m_renderer->m_size = cappedSize(rect.size());
+            m_renderer->m_onscreen = isBackground() || (isVisible() && rect.intersects(windowRect));
+            m_renderer->m_maxFps = m_maxFps;
+            if (m_displayFps > 0)
+                m_renderer->m_displayFps = m_displayFps;
         }
     }
 
     void onInvalidate()
     {
-        if (m_renderer)
+        if (m_renderer) {
+            m_scheduler->remove(m_renderer);
             delete m_renderer;
+        }
         m_renderer = nullptr;
+        delete m_mpvThread;
+        m_mpvThread = nullptr;
     }
 
 private:
+    bool isBackground() const
+    {
+        return width() <= 0 || height() <= 0;
+    }
+
+    QSize cappedSize(QSize size) const
+    {
+        if (m_maxHeight <= 0 || size.height() <= m_maxHeight)
+            return size;
+        return QSize(qRound(size.width() * qreal(m_maxHeight) / size.height()), m_maxHeight);
+    }
+
     mpv_handle* m_mpv;
     PlayerRenderer* m_renderer;
+    RenderScheduler* m_scheduler = nullptr;
+    MpvRenderThread* m_mpvThread = nullptr;
+    QOffscreenSurface* m_offscreen = nullptr;
+    QMetaObject::Connection m_screenConnection;
+    QTimer m_timingTimer;
+    qreal m_displayFps = 0;
+    qreal m_maxFps = 0;
+    int m_maxHeight = 0;
+    int m_wakeFd = -1;
+    QSocketNotifier* m_wakeNotifier = nullptr;
+    std::atomic<bool> m_repaintPending{false};
+    FrameStats m_stats;
 };
 
-int main(int argc, char* argv[])
+// Held frames go through the item's coalesced repaint path
+void PlayerRenderer::requestRepaint()
 {
-    // Must initialize QtWebEngine before QGuiApplication
-    QtWebEngine::initialize();
+    m_item->requestRepaint();
+}
 
-    QGuiApplication app(argc, argv);
+void PlayerRenderer::on_update(void* ctx)
+{
+    PlayerRenderer* self = (PlayerRenderer*)ctx;
+    self->m_item->scheduleRepaint();
+}
 
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <video-file>\n", argv[0]);
-        return 1;
-    }
+void MpvRenderThread::run()
+{
+    m_context->makeCurrent(m_surface);
+    QOpenGLExtraFunctions* gl = m_context->extraFunctions();
 
-    const char* videoFile = argv[1];
+    mpv_opengl_init_params opengl_params = {
+        get_proc_address,
+        nullptr
+    };
+    mpv_render_param params[] = {
+        {MPV_RENDER_PARAM_API_TYPE, (void*)MPV_RENDER_API_TYPE_OPENGL},
+        {MPV_RENDER_PARAM_OPENGL_INIT_PARAMS, &opengl_params},
+        {MPV_RENDER_PARAM_INVALID}
+    };
+    if (mpv_render_context_create(&m_mpvGL, m_mpv, params) < 0)
+        qFatal("Could not initialize mpv render thread");
+    mpv_render_context_set_update_callback(m_mpvGL, on_update, this);
+    emit m_item->rendererInitialized();
 
-    // Required for mpv to work correctly with number formatting
-    // Must be set after QGuiApplication as Qt may override it
-    setlocale(LC_NUMERIC, "C");
+    while (true) {
+        QSize size;
+        bool redraw;
+        {
+            QMutexLocker lock(&m_mutex);
+            while (!m_updatePending && !m_redraw && !m_quit)
+                m_cond.wait(&m_mutex);
+            if (m_quit)
+                break;
+            m_updatePending = false;
+            redraw = m_redraw;
+            m_redraw = false;
+            size = m_size;
+        }
+
+        bool newFrame = mpv_render_context_update(m_mpvGL) & MPV_RENDER_UPDATE_FRAME;
+        if ((!newFrame && !redraw) || size.isEmpty())
+            continue;
+
+        // Neither the newest frame nor the one Qt samples; the ring always has one
+        int index = 0;
+        GLsync released;
+        {
+            QMutexLocker lock(&m_mutex);
+            while (index == m_latest || index == m_inUse)
+                index++;
+            released = m_slots[index].released;
+            m_slots[index].released = nullptr;
+        }
+        Slot& slot = m_slots[index];
+        if (released) {
+            gl->glWaitSync(released, 0, GL_TIMEOUT_IGNORED);
+            gl->glDeleteSync(released);
+        }
+        if (!slot.fbo || slot.fbo->size() != size) {
+            delete slot.fbo;
+            slot.fbo = new QOpenGLFramebufferObject(size);
+        }
+
+        mpv_opengl_fbo mpv_fbo = {
+            (int)slot.fbo->handle(),
+            size.width(),
+            size.height()
+        };
+        int flip = 0;
+        mpv_render_param render_params[] = {
+            {MPV_RENDER_PARAM_OPENGL_FBO, &mpv_fbo},
+            {MPV_RENDER_PARAM_FLIP_Y, &flip},
+            {MPV_RENDER_PARAM_INVALID}
+        };
+        mpv_render_context_render(m_mpvGL, render_params);
+
+        if (slot.ready)
+            gl->glDeleteSync(slot.ready);
+        slot.ready = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        gl->glFlush();
+        mpv_render_context_report_swap(m_mpvGL);
+
+        {
+            QMutexLocker lock(&m_mutex);
+            m_latest = index;
+        }
+        m_stats->frameRendered();
+        m_item->requestRepaint();
+    }
 
-    // Create and initialize MPV (following JMP's initialization)
+    mpv_render_context_free(m_mpvGL);
+    m_mpvGL = nullptr;
+    for (Slot& slot : m_slots) {
+        delete slot.fbo;
+        if (slot.ready)
+            gl->glDeleteSync(slot.ready);
+        if (slot.released)
+            gl->glDeleteSync(slot.released);
+        slot = Slot();
+    }
+    m_context->doneCurrent();
+    delete m_context;
+    m_context = nullptr;
+}
+
+// Create and initialize one MPV instance (following JMP's initialization) and
+// start opening its file; video stays off until its renderer exists. The pause
+// state the profile asked for is returned in resumePause, for attachMpv
+static mpv_handle* createMpv(const char* videoFile, const QByteArray& stress, bool wall, int* resumePause)
+{
     mpv_handle* mpv = mpv_create();
-    if (!mpv) {
+    if (!mpv)
         qFatal("Failed to create MPV instance");
-        return 1;
-    }
 
     // Set properties BEFORE initialization (like JMP does)
     mpv_set_option_string(mpv, "osd-level", "0");  // Disable OSD
     mpv_set_option_string(mpv, "ytdl", "no");      // Disable ytdl
     mpv_set_option_string(mpv, "audio-fallback-to-null", "yes");
     mpv_set_option_string(mpv, "terminal", "yes");
-    mpv_set_option_string(mpv, "msg-level", "all=v");
 
-    if (mpv_initialize(mpv) < 0) {
+    // Profile before the benchmark and VO settings below, which must win
+    for (const MpvProfile::Option& option : activeMpvProfile().options)
+        mpv_set_option_string(mpv, option.first.constData(), option.second.constData());
+
+    // Wall streams: software decode for the benchmark, no audio, loop forever
+    if (wall) {
+        mpv_set_option_string(mpv, "hwdec", "no");
+        mpv_set_option_string(mpv, "aid", "no");
+        mpv_set_option_string(mpv, "loop-file", "inf");
+    }
+
+    // MPV_OVERLAY_STRESS=video: make every mpv frame expensive
+    if (stress == "video") {
+        mpv_set_option_string(mpv, "scale", "ewa_lanczossharp");
+        mpv_set_option_string(mpv, "cscale", "ewa_lanczossharp");
+        mpv_set_option_string(mpv, "deband", "yes");
+        mpv_set_option_string(mpv, "deband-iterations", "4");
+    }
+
+    // Open, probe and start demuxing right away. vo=libmpv can't initialize
+    // before the render context exists, so the null VO stands in until
+    // attachMpv's renderer is up
+    mpv_set_option_string(mpv, "vo", "null");
+
+    if (mpv_initialize(mpv) < 0)
         qFatal("Failed to initialize MPV");
+
+    // Hold on the first frame meanwhile, remembering what the profile asked for
+    *resumePause = 0;
+    mpv_get_property(mpv, "pause", MPV_FORMAT_FLAG, resumePause);
+    mpv_set_property_string(mpv, "pause", "yes");
+
+    const char* cmd[] = {"loadfile", videoFile, nullptr};
+    mpv_command_async(mpv, 0, cmd);
+    return mpv;
+}
+
+// Hand an mpv instance to an item; playback resumes with createMpv's
+// resumePause once its renderer is ready
+static void attachMpv(PlayerQuickItem* item, mpv_handle* mpv, int resumePause)
+{
+    // Set vo=libmpv only once the render context exists (critical - it fails
+    // to initialize before). Changing the VO reinitializes the video chain, so
+    // frames decoded for the null VO are dropped; the opened file and the
+    // demuxer cache carry over
+    QObject::connect(item, &PlayerQuickItem::rendererInitialized, item, [mpv, resumePause]() {
+        qDebug() << "Renderer initialized after" << startupTimer.elapsed() << "ms";
+        mpv_set_property_string(mpv, "vo", "libmpv");
+        int paused = resumePause;
+        mpv_set_property(mpv, "pause", MPV_FORMAT_FLAG, &paused);
+    }, Qt::QueuedConnection);
+    item->setMpvHandle(mpv);
+}
+
+static void findWallItems(QQuickItem* item, QList<PlayerQuickItem*>& items)
+{
+    for (QQuickItem* child : item->childItems()) {
+        PlayerQuickItem* video = qobject_cast<PlayerQuickItem*>(child);
+        if (video && video->objectName().startsWith("wall"))
+            items.append(video);
+        findWallItems(child, items);
+    }
+}
+
+// Wall benchmark: a stream count is sustainable while the decoders keep up
+static void startWallBenchmark(QQuickWindow* window, QList<PlayerQuickItem*> items, QList<mpv_handle*> mpvs)
+{
+    struct Totals { qint64 rendered = 0, decoderDrops = 0, voDrops = 0; };
+    std::shared_ptr<Totals> last = std::make_shared<Totals>();
+    QTimer* timer = new QTimer(window);
+    QObject::connect(timer, &QTimer::timeout, window, [items, mpvs, last]() {
+        Totals now;
+        for (PlayerQuickItem* item : items)
+            now.rendered += item->framesRendered();
+        for (mpv_handle* mpv : mpvs) {
+            int64_t decoder = 0, vo = 0;
+            mpv_get_property(mpv, "decoder-frame-drop-count", MPV_FORMAT_INT64, &decoder);
+            mpv_get_property(mpv, "frame-drop-count", MPV_FORMAT_INT64, &vo);
+            now.decoderDrops += decoder;
+            now.voDrops += vo;
+        }
+        qint64 decoderDrops = now.decoderDrops - last->decoderDrops;
+        qint64 voDrops = now.voDrops - last->voDrops;
+        qDebug("wall: %d streams on %d cores, %.1f fps rendered, %lld decoder drops, %lld vo drops -> %s",
+               mpvs.size(), QThread::idealThreadCount(), (now.rendered - last->rendered) / 5.0,
+               (long long)decoderDrops, (long long)voDrops,
+               decoderDrops + voDrops == 0 ? "sustainable" : "overloaded");
+        *last = now;
+    });
+    timer->start(5000);
+}
+
+int main(int argc, char* argv[])
+{
+    startupTimer.start();
+    activeMpvProfile() = mpvProfileFromArguments(argc, argv);
+
+    // Must initialize QtWebEngine before QGuiApplication
+    QtWebEngine::initialize();
+
+    QGuiApplication app(argc, argv);
+
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <video-file> [more files for a video wall]\n", argv[0]);
         return 1;
     }
 
+    threadedRendering = qEnvironmentVariableIntValue("MPV_OVERLAY_THREADED") != 0;
+    const QByteArray stress = qgetenv("MPV_OVERLAY_STRESS");
+
+    // Several files, or MPV_OVERLAY_WALL=N, play as a wall of MpvVideo items
+    int wallStreams = qEnvironmentVariableIntValue("MPV_OVERLAY_WALL");
+    if (wallStreams <= 0 && argc > 2)
+        wallStreams = argc - 1;
+    bool wall = wallStreams > 0;
+
+    // Required for mpv to work correctly with number formatting
+    // Must be set after QGuiApplication as Qt may override it
+    setlocale(LC_NUMERIC, "C");
+
+    qDebug() << "mpv profile:" << activeMpvProfile().describe().constData();
+    QList<mpv_handle*> mpvs;
+    QList<int> resumePauses;
+    for (int i = 0; i < qMax(wallStreams, 1); i++) {
+        int paused;
+        mpvs.append(createMpv(argv[1 + i % (argc - 1)], stress, wall, &paused));
+        resumePauses.append(paused);
+    }
+
     // Register QML type
     qmlRegisterType<PlayerQuickItem>("mpvtest", 1, 0, "MpvVideo");
 
@@ -237,27 +1018,38 @@ int main(int argc, char* argv[])
     {
         // Create QML engine and expose MPV handle
         QQmlApplicationEngine engine;
-        PlayerQuickItem* videoItem = nullptr;
+        engine.rootContext()->setContextProperty("wallStreams", wallStreams);
 
         // Load video file after QML is loaded
         QObject::connect(&engine, &QQmlApplicationEngine::objectCreated, [&](QObject* obj, const QUrl&) {
             if (obj) {
                 QQuickWindow* window = qobject_cast<QQuickWindow*>(obj);
                 if (window) {
-                    // Set vo=libmpv AFTER window is ready (critical - must happen after window creation)
-                    mpv_set_property_string(mpv, "vo", "libmpv");
-
-                    videoItem = window->findChild<PlayerQuickItem*>("video");
-                    if (videoItem) {
-                        videoItem->setMpvHandle(mpv);
-
-                        // Load video with small delay to ensure rendering pipeline is fully initialized
-                        // JMP uses Qt::QueuedConnection pattern, but here we need more time for WebEngine
-                        QTimer::singleShot(100, [videoFile, mpv]() {
-                            const char* cmd[] = {"loadfile", videoFile, nullptr};
-                            mpv_command_async(mpv, 0, cmd);
-                        });
+                    // MPV_OVERLAY_STRESS=overlay: every overlay frame costs 40 ms and schedules another
+                    if (stress == "overlay") {
+                        QObject::connect(window, &QQuickWindow::beforeRendering, window, []() {
+                            QThread::msleep(40);
+                        }, Qt::DirectConnection);
+                        QObject::connect(window, &QQuickWindow::frameSwapped, window, &QQuickWindow::update, Qt::QueuedConnection);
+                    }
+
+                    if (!wall) {
+                        PlayerQuickItem* videoItem = window->findChild<PlayerQuickItem*>("video");
+                        if (videoItem)
+                            attachMpv(videoItem, mpvs.first(), resumePauses.first());
+                        return;
+                    }
+
+                    QList<PlayerQuickItem*> items;
+                    findWallItems(window->contentItem(), items);
+                    qreal maxFps = qgetenv("MPV_OVERLAY_WALL_FPS").toDouble();
+                    int maxHeight = qEnvironmentVariableIntValue("MPV_OVERLAY_WALL_HEIGHT");
+                    for (int i = 0; i < items.size() && i < mpvs.size(); i++) {
+                        items[i]->setMaxFps(maxFps);
+                        items[i]->setMaxHeight(maxHeight);
+                        attachMpv(items[i], mpvs[i], resumePauses[i]);
                     }
+                    startWallBenchmark(window, items, mpvs);
                 }
             }
         });
@@ -267,7 +1059,8 @@ int main(int argc, char* argv[])
         result = app.exec();
     } // engine destroyed here, before mpv cleanup
 
-    mpv_terminate_destroy(mpv);
+    for (mpv_handle* mpv : mpvs)
+        mpv_terminate_destroy(mpv);
     return result;
 }
 
@@ -6,22 +6,40 @@
 
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
+#include <QQmlContext>
 #include <QQuickWindow>
+#include <QQuickGraphicsDevice>
+#include <QScreen>
+#include <QTimer>
 #include <QVulkanInstance>
 #include <QtWebEngineQuick/QtWebEngineQuick>
 #include <qpa/qplatformnativeinterface.h>
 
 #include <wayland-client.h>
+#include "presentation-time-client-protocol.h"
+#include "viewporter-client-protocol.h"
 #include <mpv/client.h>
 #include <mpv/render_vk.h>
+#include "mpvprofile.h"
 
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <clocale>
+#include <cmath>
+#include <ctime>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <unistd.h>
 #include <algorithm>
 #include <vector>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 
 // Wayland globals
 static struct wl_display *wl_display = nullptr;
@@ -29,13 +47,28 @@ static struct wl_compositor *wl_compositor = nullptr;
 static struct wl_subcompositor *wl_subcompositor = nullptr;
 static struct wl_surface *mpv_surface = nullptr;
 static struct wl_subsurface *mpv_subsurface = nullptr;
-
-// Vulkan for mpv (separate from Qt's Vulkan)
+static struct wp_presentation *wp_presentation = nullptr;
+static clockid_t presentation_clock = CLOCK_MONOTONIC;
+static struct wl_shm *wl_shm = nullptr;
+static struct wp_viewporter *wp_viewporter = nullptr;
+
+// Native size mode: swapchain at video size, compositor scales via wp_viewport
+static bool native_size = false;
+static struct wp_viewport *mpv_viewport = nullptr;
+static struct wl_surface *backdrop_surface = nullptr;
+static struct wl_subsurface *backdrop_subsurface = nullptr;
+static struct wp_viewport *backdrop_viewport = nullptr;
+
+// Vulkan for mpv (separate from Qt's Vulkan, unless shared_device)
+static bool shared_device = false;
+// Requested but unavailable (one queue): timings measure separate devices
+static bool shared_device_fallback = false;
 static VkInstance vk_instance = VK_NULL_HANDLE;
 static VkPhysicalDevice vk_physical_device = VK_NULL_HANDLE;
 static VkDevice vk_device = VK_NULL_HANDLE;
 static VkQueue vk_queue = VK_NULL_HANDLE;
 static uint32_t vk_queue_family = 0;
+static uint32_t vk_queue_index = 0;
 static VkSurfaceKHR vk_surface = VK_NULL_HANDLE;
 static VkSwapchainKHR vk_swapchain = VK_NULL_HANDLE;
 static std::vector<VkImage> swapchain_images;
@@ -44,6 +77,59 @@ static VkFormat swapchain_format;
 static VkColorSpaceKHR swapchain_colorspace;
 static int sw_width = 1280, sw_height = 720;
 
+// Frames in flight: per-slot fence + acquire semaphore, per-image render-complete semaphore
+struct FrameSlot {
+    VkFence in_flight = VK_NULL_HANDLE;
+    VkSemaphore image_acquired = VK_NULL_HANDLE;
+    VkCommandBuffer begin_cmd = VK_NULL_HANDLE;  // acquire barrier + start timestamp
+    VkCommandBuffer end_cmd = VK_NULL_HANDLE;    // end timestamp
+    uint64_t serial = 0;  // frame last submitted with this slot
+    bool timed = false;   // timestamps pending for serial
+};
+static int frames_in_flight = 2;
+
+// Latency modes (MPV_OVERLAY_LATENCY): swapchain depth, present mode and when to start rendering
+enum class LatencyMode { Fifo, FifoMin, Mailbox, Late };
+static LatencyMode latency_mode = LatencyMode::Fifo;
+static double render_budget_ms = 8.0;  // decaying max of recent CPU+GPU frame cost
+static std::vector<FrameSlot> frame_slots;
+static std::vector<VkSemaphore> render_complete;
+static std::vector<VkFence> image_fences;
+static VkCommandPool vk_command_pool = VK_NULL_HANDLE;
+static VkQueryPool timestamp_pool = VK_NULL_HANDLE;
+static double timestamp_period_ns = 0.0;
+static uint64_t frames_submitted = 0;
+static uint64_t frames_completed = 0;
+
+// Swapchains replaced by a resize, destroyed once a later frame has completed
+struct RetiredSwapchain {
+    VkSwapchainKHR swapchain;
+    std::vector<VkImageView> views;
+    std::vector<VkSemaphore> render_complete;
+    uint64_t retired_at;
+};
+static std::vector<RetiredSwapchain> retired_swapchains;
+
+// Swapchain rebuild stall times, reported with the frame timings
+struct ResizeStats {
+    int rebuilds = 0;
+    double stall_sum = 0, stall_max = 0;
+
+    void add(double stall_ms) {
+        rebuilds++;
+        stall_sum += stall_ms;
+        stall_max = std::max(stall_max, stall_ms);
+    }
+
+    void report() {
+        if (rebuilds == 0) return;
+        fprintf(stderr, "*** %d swapchain rebuilds: stall avg %.2f ms (max %.2f), %zu retired pending ***\n",
+                rebuilds, stall_sum / rebuilds, stall_max, retired_swapchains.size());
+        *this = ResizeStats();
+    }
+};
+static ResizeStats resize_stats;
+
 // mpv
 static mpv_handle *mpv = nullptr;
 static mpv_render_context *mpv_render = nullptr;
@@ -52,6 +138,79 @@ static std::atomic<bool> needs_resize{false};
 static std::atomic<int> pending_width{0};
 static std::atomic<int> pending_height{0};
 
+// Render thread sleeps until mpv has something new (or a resize/shutdown)
+static std::mutex render_mutex;
+static std::condition_variable render_cv;
+static bool render_update_pending = false;
+static std::atomic<uint64_t> update_callbacks{0};
+
+// Event thread owns mpv's event queue, woken by mpv_set_wakeup_callback
+static std::mutex event_mutex;
+static std::condition_variable event_cv;
+static bool event_pending = false;
+static std::atomic<bool> event_running{true};
+
+// Compact playback state snapshot published by the event thread
+struct PlaybackState {
+    bool paused = false;
+    bool ended = false;
+    bool hdr = false;
+    double time_pos = 0.0;
+    double fps = 0.0;
+    int video_width = 0;
+    int video_height = 0;
+    double vsync_jitter = 0.0;
+    int64_t mistimed_frames = 0;
+    int64_t delayed_frames = 0;
+};
+static std::mutex state_mutex;
+static PlaybackState playback_state;
+
+static PlaybackState playback_snapshot() {
+    std::lock_guard<std::mutex> lock(state_mutex);
+    return playback_state;
+}
+
+// Playback state for QML, refreshed from the event thread's snapshots
+class PlayerState : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool paused READ paused NOTIFY changed)
+    Q_PROPERTY(double timePos READ timePos NOTIFY changed)
+    Q_PROPERTY(QSize videoSize READ videoSize NOTIFY changed)
+    Q_PROPERTY(bool hdr READ hdr NOTIFY changed)
+    Q_PROPERTY(double vsyncJitter READ vsyncJitter NOTIFY changed)
+    Q_PROPERTY(qint64 mistimedFrames READ mistimedFrames NOTIFY changed)
+    Q_PROPERTY(qint64 delayedFrames READ delayedFrames NOTIFY changed)
+
+public:
+    using QObject::QObject;
+
+    bool paused() const { return m_state.paused; }
+    double timePos() const { return m_state.time_pos; }
+    QSize videoSize() const { return QSize(m_state.video_width, m_state.video_height); }
+    bool hdr() const { return m_state.hdr; }
+    double vsyncJitter() const { return m_state.vsync_jitter; }
+    qint64 mistimedFrames() const { return m_state.mistimed_frames; }
+    qint64 delayedFrames() const { return m_state.delayed_frames; }
+
+    void update(const PlaybackState &state) {
+        m_state = state;
+        emit changed();
+    }
+
+Q_SIGNALS:
+    void changed();
+
+private:
+    PlaybackState m_state;
+};
+
+static PlayerState *gui_state = nullptr;
+// Qt's window, for parent commits the subsurface needs; set before the render thread starts
+static QQuickWindow *qt_window = nullptr;
+static std::atomic<bool> gui_update_queued{false};
+
 // Device extensions - match standalone test
 static const char *device_exts[] = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME,
@@ -78,12 +237,91 @@ static void check_vk(VkResult result, const char *msg) {
     }
 }
 
+static int env_int(const char *name, int fallback) {
+    const char *value = getenv(name);
+    return (value && *value) ? atoi(value) : fallback;
+}
+
+static LatencyMode parse_latency_mode(const char *value) {
+    if (!value || !*value || strcmp(value, "fifo") == 0) return LatencyMode::Fifo;
+    if (strcmp(value, "fifo-min") == 0) return LatencyMode::FifoMin;
+    if (strcmp(value, "mailbox") == 0) return LatencyMode::Mailbox;
+    if (strcmp(value, "late") == 0) return LatencyMode::Late;
+    fprintf(stderr, "Unknown latency mode '%s', using fifo\n", value);
+    return LatencyMode::Fifo;
+}
+
+static const char *latency_mode_name() {
+    switch (latency_mode) {
+    case LatencyMode::FifoMin: return "fifo-min";
+    case LatencyMode::Mailbox: return "mailbox";
+    case LatencyMode::Late: return "late";
+    default: return "fifo";
+    }
+}
+
+static double ms_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::chrono::steady_clock::time_point startup_time;
+static std::atomic<bool> first_overlay_frame{false};
+
+static double rss_mb() {
+    long pages = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+        fclose(f);
+    }
+    return resident * (double)sysconf(_SC_PAGESIZE) / (1024 * 1024);
+}
+
+static void wake_render_thread() {
+    {
+        std::lock_guard<std::mutex> lock(render_mutex);
+    }
+    render_cv.notify_one();
+}
+
+static void on_mpv_render_update(void *) {
+    update_callbacks++;
+    {
+        std::lock_guard<std::mutex> lock(render_mutex);
+        render_update_pending = true;
+    }
+    render_cv.notify_one();
+}
+
+static void on_mpv_wakeup(void *) {
+    {
+        std::lock_guard<std::mutex> lock(event_mutex);
+        event_pending = true;
+    }
+    event_cv.notify_one();
+}
+
+static void presentation_clock_id(void *, struct wp_presentation *, uint32_t clk_id) {
+    presentation_clock = (clockid_t)clk_id;
+}
+
+static const struct wp_presentation_listener presentation_listener = {
+    .clock_id = presentation_clock_id,
+};
+
 static void registry_global(void *, struct wl_registry *registry, uint32_t name,
                             const char *interface, uint32_t) {
     if (strcmp(interface, wl_compositor_interface.name) == 0) {
         wl_compositor = (struct wl_compositor *)wl_registry_bind(registry, name, &wl_compositor_interface, 4);
     } else if (strcmp(interface, wl_subcompositor_interface.name) == 0) {
         wl_subcompositor = (struct wl_subcompositor *)wl_registry_bind(registry, name, &wl_subcompositor_interface, 1);
+    } else if (strcmp(interface, wl_shm_interface.name) == 0) {
+        wl_shm = (struct wl_shm *)wl_registry_bind(registry, name, &wl_shm_interface, 1);
+    } else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
+        wp_viewporter = (struct wp_viewporter *)wl_registry_bind(registry, name, &wp_viewporter_interface, 1);
+    } else if (strcmp(interface, wp_presentation_interface.name) == 0) {
+        wp_presentation = (struct wp_presentation *)wl_registry_bind(registry, name, &wp_presentation_interface, 1);
+        wp_presentation_add_listener(wp_presentation, &presentation_listener, nullptr);
     }
 }
 
@@ -94,7 +332,334 @@ static const struct wl_registry_listener registry_listener = {
     .global_remove = registry_global_remove,
 };
 
-static void create_vulkan_for_mpv() {
+// Display timing for mpv: refresh rate from presentation feedback (or QScreen
+// until feedback arrives) goes to display-fps-override, and swaps are reported
+// when the compositor says the frame was presented.
+static std::atomic<double> display_fps{0.0};
+static std::atomic<bool> feedback_refresh_known{false};
+
+static void set_display_fps(double hz, const char *source) {
+    if (!mpv || hz <= 0) return;
+    if (std::fabs(display_fps.exchange(hz) - hz) < 0.005) return;
+
+    char value[32];
+    snprintf(value, sizeof(value), "%.3f", hz);
+    char *data = value;
+    mpv_set_property_async(mpv, 0, "display-fps-override", MPV_FORMAT_STRING, &data);
+    fprintf(stderr, "*** display-fps-override %s (%s) ***\n", value, source);
+}
+
+// Render thread only: the render API allows one mpv_render_* call at a time
+static void report_swap() {
+    if (mpv_render)
+        mpv_render_context_report_swap(mpv_render);
+}
+
+// Swaps the feedback thread has seen, reported by the render thread before
+// its next update/render; bumped under present_mutex
+static std::atomic<int> swaps_pending{0};
+
+static void drain_swaps() {
+    for (int n = swaps_pending.exchange(0); n > 0; n--)
+        report_swap();
+}
+
+// Presentation feedback for the mpv subsurface. Feedback objects live on their
+// own queue, dispatched by a feedback thread so swaps are reported promptly.
+struct PresentRecord {
+    uint64_t seq = 0;         // our submit counter, 0 = unused
+    uint64_t commit_ns = 0;   // presentation clock just before vkQueuePresentKHR
+    uint64_t target_ns = 0;   // mpv's target display time, 0 if unknown
+    uint64_t present_ns = 0;
+    uint64_t msc = 0;
+    uint32_t refresh_ns = 0;
+    bool done = false;
+    bool discarded = false;
+};
+static const size_t present_ring_size = 256;
+static PresentRecord present_ring[present_ring_size];
+static uint64_t present_seq = 0;
+static uint64_t present_reported = 0;  // last seq included in a report
+static int presents_pending = 0;       // presents without feedback yet
+static int queue_depth_samples = 0, queue_depth_sum = 0, queue_depth_max = 0;
+static std::mutex present_mutex;  // ring and counters: render thread vs feedback thread
+static struct wl_event_queue *feedback_queue = nullptr;
+static struct wp_presentation *feedback_presentation = nullptr;
+static std::thread *feedback_thread = nullptr;
+static std::atomic<bool> feedback_running{false};
+static int feedback_wake_fd = -1;
+
+static uint64_t presentation_now_ns() {
+    struct timespec ts;
+    clock_gettime(presentation_clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static PresentRecord *present_record(void *data) {
+    uint64_t seq = (uint64_t)(uintptr_t)data;
+    PresentRecord &rec = present_ring[seq % present_ring_size];
+    return rec.seq == seq ? &rec : nullptr;
+}
+
+static void feedback_sync_output(void *, struct wp_presentation_feedback *, struct wl_output *) {}
+
+static void feedback_presented(void *data, struct wp_presentation_feedback *feedback,
+                               uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec,
+                               uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t) {
+    {
+        std::lock_guard<std::mutex> lock(present_mutex);
+        swaps_pending++;
+        if (PresentRecord *rec = present_record(data)) {
+            rec->present_ns = (((uint64_t)tv_sec_hi << 32) | tv_sec_lo) * 1000000000ull + tv_nsec;
+            rec->msc = ((uint64_t)seq_hi << 32) | seq_lo;
+            rec->refresh_ns = refresh;
+            rec->done = true;
+        }
+        presents_pending--;
+    }
+    wp_presentation_feedback_destroy(feedback);
+    wake_render_thread();
+
+    if (refresh > 0) {
+        feedback_refresh_known = true;
+        set_display_fps(1e9 / refresh, "presentation feedback");
+    }
+}
+
+static void feedback_discarded(void *data, struct wp_presentation_feedback *feedback) {
+    // mpv waits for one swap report per rendered frame, shown or not
+    {
+        std::lock_guard<std::mutex> lock(present_mutex);
+        swaps_pending++;
+        if (PresentRecord *rec = present_record(data)) {
+            rec->discarded = true;
+            rec->done = true;
+        }
+        presents_pending--;
+    }
+    wp_presentation_feedback_destroy(feedback);
+    wake_render_thread();
+}
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+    .sync_output = feedback_sync_output,
+    .presented = feedback_presented,
+    .discarded = feedback_discarded,
+};
+
+static void create_presentation_feedback() {
+    if (!wp_presentation) {
+        fprintf(stderr, "*** wp_presentation not available, no present timing ***\n");
+        return;
+    }
+    feedback_queue = wl_display_create_queue(wl_display);
+    feedback_presentation = (struct wp_presentation *)wl_proxy_create_wrapper(wp_presentation);
+    wl_proxy_set_queue((struct wl_proxy *)feedback_presentation, feedback_queue);
+}
+
+// Must be called right before the present that commits mpv_surface; returns
+// false if there is no feedback and the caller has to report the swap itself
+static bool request_presentation_feedback(uint64_t target_ns) {
+    if (!feedback_presentation) return false;
+
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(present_mutex);
+
+        // Frames queued ahead of the display, sampled before this one joins them
+        queue_depth_samples++;
+        queue_depth_sum += presents_pending;
+        queue_depth_max = std::max(queue_depth_max, presents_pending);
+        presents_pending++;
+
+        seq = ++present_seq;
+        PresentRecord &rec = present_ring[seq % present_ring_size];
+        rec = PresentRecord();
+        rec.seq = seq;
+        rec.commit_ns = presentation_now_ns();
+        rec.target_ns = target_ns;
+    }
+    struct wp_presentation_feedback *feedback = wp_presentation_feedback(feedback_presentation, mpv_surface);
+    wp_presentation_feedback_add_listener(feedback, &feedback_listener, (void *)(uintptr_t)seq);
+    return true;
+}
+
+// Reads the Wayland socket alongside Qt using the prepare_read protocol and
+// dispatches only our feedback queue; feedback_wake_fd interrupts the poll
+static void feedback_loop() {
+    int display_fd = wl_display_get_fd(wl_display);
+    while (feedback_running) {
+        while (wl_display_prepare_read_queue(wl_display, feedback_queue) != 0)
+            wl_display_dispatch_queue_pending(wl_display, feedback_queue);
+        wl_display_flush(wl_display);
+
+        struct pollfd fds[2] = {{display_fd, POLLIN, 0}, {feedback_wake_fd, POLLIN, 0}};
+        if (poll(fds, 2, -1) > 0 && (fds[0].revents & POLLIN))
+            wl_display_read_events(wl_display);
+        else
+            wl_display_cancel_read(wl_display);
+        wl_display_dispatch_queue_pending(wl_display, feedback_queue);
+    }
+}
+
+static void start_feedback_thread() {
+    if (!feedback_queue) return;
+    feedback_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    feedback_running = true;
+    feedback_thread = new std::thread(feedback_loop);
+}
+
+static void stop_feedback_thread() {
+    if (!feedback_thread) return;
+    feedback_running = false;
+    uint64_t one = 1;
+    if (write(feedback_wake_fd, &one, sizeof(one)) != sizeof(one))
+        fprintf(stderr, "Failed to wake feedback thread\n");
+    feedback_thread->join();
+    delete feedback_thread;
+    feedback_thread = nullptr;
+    close(feedback_wake_fd);
+    feedback_wake_fd = -1;
+}
+
+// Jitter, missed vblanks and present latency over the frames completed since the last report
+static void report_presentation_stats(double video_fps) {
+    if (!feedback_queue) return;
+    std::lock_guard<std::mutex> lock(present_mutex);
+
+    int presented = 0, discarded = 0;
+    uint64_t missed = 0;
+    double latency_sum = 0, latency_max = 0;
+    double interval_sum = 0, interval_sq_sum = 0;
+    int intervals = 0;
+    int targeted = 0;
+    double error_sum = 0, error_sq_sum = 0;
+    uint32_t refresh_ns = 0;
+    const PresentRecord *prev = nullptr;
+
+    uint64_t first = present_seq > present_ring_size ? present_seq - present_ring_size + 1 : 1;
+    first = std::max(first, present_reported + 1);
+    uint64_t last = present_reported;
+    for (uint64_t seq = first; seq <= present_seq; seq++) {
+        const PresentRecord &rec = present_ring[seq % present_ring_size];
+        if (rec.seq != seq || !rec.done) break;
+        last = seq;
+        if (rec.discarded) {
+            discarded++;
+            continue;
+        }
+        presented++;
+        refresh_ns = rec.refresh_ns;
+        double latency = (rec.present_ns - rec.commit_ns) / 1e6;
+        latency_sum += latency;
+        latency_max = std::max(latency_max, latency);
+        if (rec.target_ns) {
+            double error = ((double)rec.present_ns - (double)rec.target_ns) / 1e6;
+            error_sum += error;
+            error_sq_sum += error * error;
+            targeted++;
+        }
+        if (prev) {
+            double interval = (rec.present_ns - prev->present_ns) / 1e6;
+            interval_sum += interval;
+            interval_sq_sum += interval * interval;
+            intervals++;
+
+            // Expected vblanks per video frame, e.g. 2.5 for 24fps on 60Hz
+            double expected = 1.0;
+            if (video_fps > 0 && rec.refresh_ns > 0)
+                expected = std::max(1.0, 1e9 / rec.refresh_ns / video_fps);
+            uint64_t delta = rec.msc - prev->msc;
+            if (delta > (uint64_t)std::ceil(expected))
+                missed += delta - (uint64_t)std::ceil(expected);
+        }
+        prev = &rec;
+    }
+    present_reported = last;
+    if (presented == 0 && discarded == 0) return;
+
+    double mean = intervals ? interval_sum / intervals : 0;
+    double jitter = intervals ? std::sqrt(std::max(0.0, interval_sq_sum / intervals - mean * mean)) : 0;
+    fprintf(stderr, "*** Presentation: %d presented, %d discarded, refresh %.2f ms, interval %.2f ms "
+            "(jitter %.2f ms), %llu missed vblanks, latency avg %.2f ms (max %.2f) ***\n",
+            presented, discarded, refresh_ns / 1e6, mean, jitter, (unsigned long long)missed,
+            presented ? latency_sum / presented : 0, latency_max);
+
+    // Judder: spread of actual display time around mpv's target time
+    double error_mean = targeted ? error_sum / targeted : 0;
+    double judder = targeted ? std::sqrt(std::max(0.0, error_sq_sum / targeted - error_mean * error_mean)) : 0;
+    fprintf(stderr, "*** Pacing (%s): target error avg %.2f ms (judder %.2f ms) over %d frames, "
+            "queue depth avg %.2f (max %d), render budget %.2f ms ***\n",
+            latency_mode_name(), error_mean, judder, targeted,
+            queue_depth_samples ? (double)queue_depth_sum / queue_depth_samples : 0, queue_depth_max,
+            render_budget_ms);
+    queue_depth_samples = queue_depth_sum = queue_depth_max = 0;
+}
+
+// 1x1 black buffer scaled to the window, so letterbox bars stay opaque in native size mode
+static struct wl_buffer *create_black_buffer() {
+    int fd = memfd_create("mpv-backdrop", MFD_CLOEXEC);
+    if (fd < 0) return nullptr;
+    uint32_t pixel = 0xff000000;
+    if (write(fd, &pixel, sizeof(pixel)) != sizeof(pixel)) {
+        close(fd);
+        return nullptr;
+    }
+    struct wl_shm_pool *pool = wl_shm_create_pool(wl_shm, fd, sizeof(pixel));
+    struct wl_buffer *buffer = wl_shm_pool_create_buffer(pool, 0, 1, 1, 4, WL_SHM_FORMAT_XRGB8888);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+    return buffer;
+}
+
+static void create_native_size_surfaces(struct wl_surface *parent) {
+    if (!wp_viewporter || !wl_shm) {
+        fprintf(stderr, "*** wp_viewporter/wl_shm not available, native size disabled ***\n");
+        native_size = false;
+        return;
+    }
+    mpv_viewport = wp_viewporter_get_viewport(wp_viewporter, mpv_surface);
+
+    struct wl_buffer *black = create_black_buffer();
+    if (!black) return;
+    backdrop_surface = wl_compositor_create_surface(wl_compositor);
+    backdrop_subsurface = wl_subcompositor_get_subsurface(wl_subcompositor, backdrop_surface, parent);
+    wl_subsurface_place_below(backdrop_subsurface, mpv_surface);
+    wl_subsurface_set_desync(backdrop_subsurface);
+    backdrop_viewport = wp_viewporter_get_viewport(wp_viewporter, backdrop_surface);
+    wl_surface_attach(backdrop_surface, black, 0, 0);
+    fprintf(stderr, "*** Native size mode: compositor scales mpv subsurface ***\n");
+}
+
+// Fit the video into the window. The viewport destination lands with the next
+// mpv_surface commit (present), but the subsurface position is the parent's
+// state and only lands when Qt commits, so a parent frame is requested too.
+static void update_viewport(int win_width, int win_height, int video_width, int video_height) {
+    if (!mpv_viewport) return;
+
+    int x = 0, y = 0, w = win_width, h = win_height;
+    if (video_width > 0 && video_height > 0) {
+        if ((int64_t)win_width * video_height > (int64_t)win_height * video_width) {
+            w = std::max(1, (int)((int64_t)win_height * video_width / video_height));
+            x = (win_width - w) / 2;
+        } else {
+            h = std::max(1, (int)((int64_t)win_width * video_height / video_width));
+            y = (win_height - h) / 2;
+        }
+    }
+    wp_viewport_set_destination(mpv_viewport, w, h);
+    wl_subsurface_set_position(mpv_subsurface, x, y);
+    if (qt_window)
+        QMetaObject::invokeMethod(qt_window, [] { qt_window->update(); }, Qt::QueuedConnection);
+
+    if (backdrop_viewport) {
+        wp_viewport_set_destination(backdrop_viewport, win_width, win_height);
+        wl_surface_damage(backdrop_surface, 0, 0, win_width, win_height);
+        wl_surface_commit(backdrop_surface);
+    }
+}
+
+static void create_vulkan_device() {
     // Instance - match standalone test
     const char *instance_exts[] = {
         VK_KHR_SURFACE_EXTENSION_NAME,
@@ -111,31 +676,58 @@ static void create_vulkan_for_mpv() {
     instance_info.ppEnabledExtensionNames = instance_exts;
     check_vk(vkCreateInstance(&instance_info, nullptr, &vk_instance), "vkCreateInstance");
 
-    // Physical device
+    // Physical device and queue family: first graphics family that can present to Wayland
     uint32_t gpu_count = 0;
     vkEnumeratePhysicalDevices(vk_instance, &gpu_count, nullptr);
     std::vector<VkPhysicalDevice> gpus(gpu_count);
     vkEnumeratePhysicalDevices(vk_instance, &gpu_count, gpus.data());
-    vk_physical_device = gpus[0];
+    if (gpus.empty()) {
+        fprintf(stderr, "No Vulkan devices found\n");
+        exit(1);
+    }
 
-    // Queue family
-    uint32_t queue_family_count = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(vk_physical_device, &queue_family_count, nullptr);
-    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
-    vkGetPhysicalDeviceQueueFamilyProperties(vk_physical_device, &queue_family_count, queue_families.data());
-    for (uint32_t i = 0; i < queue_family_count; i++) {
-        if (queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-            vk_queue_family = i;
-            break;
+    uint32_t family_queue_count = 1;
+    vk_physical_device = VK_NULL_HANDLE;
+    for (VkPhysicalDevice gpu : gpus) {
+        uint32_t queue_family_count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queue_family_count, nullptr);
+        std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+        vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queue_family_count, queue_families.data());
+        for (uint32_t i = 0; i < queue_family_count; i++) {
+            if ((queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) &&
+                vkGetPhysicalDeviceWaylandPresentationSupportKHR(gpu, i, wl_display)) {
+                vk_physical_device = gpu;
+                vk_queue_family = i;
+                family_queue_count = queue_families[i].queueCount;
+                break;
+            }
         }
+        if (vk_physical_device) break;
+    }
+    if (!vk_physical_device) {
+        fprintf(stderr, "No Vulkan device can present to Wayland, using the first one\n");
+        vk_physical_device = gpus[0];
+        vk_queue_family = 0;
+    }
+
+    // Qt and mpv render from different threads, and VkQueue access must be
+    // externally synchronized, so a shared device needs a second queue.
+    // mpv_vulkan_init_params has no queue lock hook to share a single one
+    if (shared_device && family_queue_count < 2) {
+        fprintf(stderr, "*** WARNING: MPV_OVERLAY_SHARED_DEVICE=1 but queue family %u has one queue ***\n"
+                        "*** mpv gets its own device; shared-vs-separate timings from this run are INVALID ***\n",
+                vk_queue_family);
+        shared_device = false;
+        shared_device_fallback = true;
     }
+    vk_queue_index = shared_device ? 1 : 0;
 
     // Device
-    float queue_priority = 1.0f;
+    float queue_priorities[2] = {1.0f, 1.0f};
     VkDeviceQueueCreateInfo queue_info = {VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
     queue_info.queueFamilyIndex = vk_queue_family;
-    queue_info.queueCount = 1;
-    queue_info.pQueuePriorities = &queue_priority;
+    queue_info.queueCount = vk_queue_index + 1;
+    queue_info.pQueuePriorities = queue_priorities;
 
     static VkPhysicalDeviceVulkan11Features vk11_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES};
     vk11_features.samplerYcbcrConversion = VK_TRUE;
@@ -156,8 +748,13 @@ static void create_vulkan_for_mpv() {
     device_info.ppEnabledExtensionNames = device_exts;
     check_vk(vkCreateDevice(vk_physical_device, &device_info, nullptr, &vk_device), "vkCreateDevice");
 
-    vkGetDeviceQueue(vk_device, vk_queue_family, 0, &vk_queue);
+    vkGetDeviceQueue(vk_device, vk_queue_family, vk_queue_index, &vk_queue);
 
+    fprintf(stderr, "*** Created Vulkan device for mpv (shared with Qt: %s, queue %u.%u) after %.1f ms ***\n",
+            shared_device ? "yes" : "no", vk_queue_family, vk_queue_index, ms_since(startup_time));
+}
+
+static void create_vulkan_surface() {
     // Create Vulkan surface from our wl_surface
     VkWaylandSurfaceCreateInfoKHR wayland_surface_info = {VK_STRUCTURE_TYPE_WAYLAND_SURFACE_CREATE_INFO_KHR};
     wayland_surface_info.display = wl_display;
@@ -167,6 +764,157 @@ static void create_vulkan_for_mpv() {
     fprintf(stderr, "*** Created Vulkan context for mpv subsurface ***\n");
 }
 
+static void record_slot_commands(FrameSlot &slot, uint32_t query) {
+    VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+
+    // mpv can't wait on the acquire semaphore itself, so a batch containing this
+    // barrier waits on it instead; the barrier orders all later queue work after it
+    vkBeginCommandBuffer(slot.begin_cmd, &begin_info);
+    VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(slot.begin_cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+    if (timestamp_pool)
+        vkCmdWriteTimestamp(slot.begin_cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, timestamp_pool, query);
+    check_vk(vkEndCommandBuffer(slot.begin_cmd), "vkEndCommandBuffer");
+
+    // Queries are reset from the host, so both buffers are recorded once
+    vkBeginCommandBuffer(slot.end_cmd, &begin_info);
+    if (timestamp_pool)
+        vkCmdWriteTimestamp(slot.end_cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestamp_pool, query + 1);
+    check_vk(vkEndCommandBuffer(slot.end_cmd), "vkEndCommandBuffer");
+}
+
+static void create_frame_resources() {
+    VkCommandPoolCreateInfo pool_info = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    pool_info.queueFamilyIndex = vk_queue_family;
+    check_vk(vkCreateCommandPool(vk_device, &pool_info, nullptr, &vk_command_pool), "vkCreateCommandPool");
+
+    // GPU time per frame, if the queue supports timestamps
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(vk_physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(vk_physical_device, &queue_family_count, queue_families.data());
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(vk_physical_device, &props);
+    if (queue_families[vk_queue_family].timestampValidBits > 0 && props.limits.timestampPeriod > 0) {
+        VkQueryPoolCreateInfo query_info = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+        query_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        query_info.queryCount = 2 * frames_in_flight;
+        check_vk(vkCreateQueryPool(vk_device, &query_info, nullptr, &timestamp_pool), "vkCreateQueryPool");
+        vkResetQueryPool(vk_device, timestamp_pool, 0, query_info.queryCount);
+        timestamp_period_ns = props.limits.timestampPeriod;
+    }
+
+    frame_slots.resize(frames_in_flight);
+    for (size_t i = 0; i < frame_slots.size(); i++) {
+        FrameSlot &slot = frame_slots[i];
+        VkFenceCreateInfo fence_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        check_vk(vkCreateFence(vk_device, &fence_info, nullptr, &slot.in_flight), "vkCreateFence");
+        VkSemaphoreCreateInfo sem_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        check_vk(vkCreateSemaphore(vk_device, &sem_info, nullptr, &slot.image_acquired), "vkCreateSemaphore");
+
+        VkCommandBuffer cmds[2];
+        VkCommandBufferAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        alloc_info.commandPool = vk_command_pool;
+        alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc_info.commandBufferCount = 2;
+        check_vk(vkAllocateCommandBuffers(vk_device, &alloc_info, cmds), "vkAllocateCommandBuffers");
+        slot.begin_cmd = cmds[0];
+        slot.end_cmd = cmds[1];
+        record_slot_commands(slot, 2 * i);
+    }
+
+    fprintf(stderr, "*** Frames in flight: %d, GPU timestamps: %s ***\n", frames_in_flight,
+            timestamp_pool ? "yes" : "no");
+}
+
+// Returns the GPU time of the slot's last frame in ms, or -1; slot fence must be signaled
+static double read_slot_gpu_time(FrameSlot &slot) {
+    if (!slot.timed) return -1.0;
+    slot.timed = false;
+    uint32_t query = 2 * (uint32_t)(&slot - frame_slots.data());
+    uint64_t ts[2] = {};
+    VkResult result = vkGetQueryPoolResults(vk_device, timestamp_pool, query, 2, sizeof(ts), ts,
+                                            sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    vkResetQueryPool(vk_device, timestamp_pool, query, 2);
+    if (result != VK_SUCCESS || ts[1] < ts[0]) return -1.0;
+    return (ts[1] - ts[0]) * timestamp_period_ns / 1e6;
+}
+
+static void destroy_frame_resources() {
+    for (auto &slot : frame_slots) {
+        vkDestroyFence(vk_device, slot.in_flight, nullptr);
+        vkDestroySemaphore(vk_device, slot.image_acquired, nullptr);
+    }
+    frame_slots.clear();
+    vkDestroyCommandPool(vk_device, vk_command_pool, nullptr);
+    vk_command_pool = VK_NULL_HANDLE;
+    if (timestamp_pool)
+        vkDestroyQueryPool(vk_device, timestamp_pool, nullptr);
+    timestamp_pool = VK_NULL_HANDLE;
+}
+
+static int bytes_per_pixel(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+    case VK_FORMAT_R16G16B16A16_UNORM:
+        return 8;
+    default:
+        return 4;
+    }
+}
+
+// Per-image resources; caller guarantees the images are no longer in use
+static void create_image_resources() {
+    render_complete.resize(swapchain_images.size());
+    for (auto &sem : render_complete) {
+        VkSemaphoreCreateInfo sem_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+        check_vk(vkCreateSemaphore(vk_device, &sem_info, nullptr, &sem), "vkCreateSemaphore");
+    }
+    image_fences.assign(swapchain_images.size(), VK_NULL_HANDLE);
+}
+
+static void destroy_image_resources() {
+    for (auto sem : render_complete) {
+        vkDestroySemaphore(vk_device, sem, nullptr);
+    }
+    render_complete.clear();
+    image_fences.clear();
+}
+
+static VkPresentModeKHR choose_present_mode() {
+    if (latency_mode != LatencyMode::Mailbox) return VK_PRESENT_MODE_FIFO_KHR;
+
+    uint32_t mode_count = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(vk_physical_device, vk_surface, &mode_count, nullptr);
+    std::vector<VkPresentModeKHR> modes(mode_count);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(vk_physical_device, vk_surface, &mode_count, modes.data());
+    if (std::find(modes.begin(), modes.end(), VK_PRESENT_MODE_MAILBOX_KHR) != modes.end())
+        return VK_PRESENT_MODE_MAILBOX_KHR;
+
+    static bool warned = false;
+    if (!warned) {
+        fprintf(stderr, "*** MAILBOX not supported, using FIFO ***\n");
+        warned = true;
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+static uint32_t choose_image_count(const VkSurfaceCapabilitiesKHR &caps) {
+    uint32_t count = caps.minImageCount + 1;
+    if (latency_mode == LatencyMode::FifoMin || latency_mode == LatencyMode::Late)
+        count = caps.minImageCount;
+    else if (latency_mode == LatencyMode::Mailbox)
+        count = std::max(count, 3u);
+    if (caps.maxImageCount > 0)
+        count = std::min(count, caps.maxImageCount);
+    return count;
+}
+
 static void create_swapchain() {
     // Find HDR10 format
     uint32_t format_count = 0;
@@ -191,7 +939,7 @@ static void create_swapchain() {
 
     VkSwapchainCreateInfoKHR swapchain_info = {VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
     swapchain_info.surface = vk_surface;
-    swapchain_info.minImageCount = caps.minImageCount + 1;
+    swapchain_info.minImageCount = choose_image_count(caps);
     swapchain_info.imageFormat = swapchain_format;
     swapchain_info.imageColorSpace = swapchain_colorspace;
     swapchain_info.imageExtent = {(uint32_t)sw_width, (uint32_t)sw_height};
@@ -199,7 +947,7 @@ static void create_swapchain() {
     swapchain_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     swapchain_info.preTransform = caps.currentTransform;
     swapchain_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    swapchain_info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    swapchain_info.presentMode = choose_present_mode();
     swapchain_info.clipped = VK_TRUE;
     check_vk(vkCreateSwapchainKHR(vk_device, &swapchain_info, nullptr, &vk_swapchain), "vkCreateSwapchainKHR");
 
@@ -218,6 +966,8 @@ static void create_swapchain() {
         check_vk(vkCreateImageView(vk_device, &view_info, nullptr, &swapchain_views[i]), "vkCreateImageView");
     }
 
+    create_image_resources();
+
     fprintf(stderr, "*** Swapchain created: %dx%d, HDR=%d ***\n", sw_width, sw_height,
             swapchain_colorspace == VK_COLOR_SPACE_HDR10_ST2084_EXT);
 
@@ -241,15 +991,34 @@ static void create_swapchain() {
     }
 }
 
-static void recreate_swapchain(int new_width, int new_height) {
-    vkDeviceWaitIdle(vk_device);
+// Poll slot fences; the queue is in order, so the newest signaled serial covers all older frames
+static void collect_retired_swapchains() {
+    for (const auto &slot : frame_slots) {
+        if (slot.serial > frames_completed && vkGetFenceStatus(vk_device, slot.in_flight) == VK_SUCCESS)
+            frames_completed = slot.serial;
+    }
 
-    // Destroy old views and swapchain
-    for (auto view : swapchain_views) {
-        vkDestroyImageView(vk_device, view, nullptr);
+    auto it = retired_swapchains.begin();
+    while (it != retired_swapchains.end()) {
+        if (frames_completed <= it->retired_at) {
+            ++it;
+            continue;
+        }
+        for (auto view : it->views) {
+            vkDestroyImageView(vk_device, view, nullptr);
+        }
+        for (auto sem : it->render_complete) {
+            vkDestroySemaphore(vk_device, sem, nullptr);
+        }
+        vkDestroySwapchainKHR(vk_device, it->swapchain, nullptr);
+        it = retired_swapchains.erase(it);
     }
-    swapchain_views.clear();
-    swapchain_images.clear();
+}
+
+// Retires the current swapchain instead of idling the device; in-flight
+// frames keep their images until collect_retired_swapchains() frees them
+static void recreate_swapchain(int new_width, int new_height) {
+    auto start = std::chrono::steady_clock::now();
 
     VkSwapchainKHR old_swapchain = vk_swapchain;
 
@@ -262,7 +1031,7 @@ static void recreate_swapchain(int new_width, int new_height) {
 
     VkSwapchainCreateInfoKHR swapchain_info = {VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR};
     swapchain_info.surface = vk_surface;
-    swapchain_info.minImageCount = caps.minImageCount + 1;
+    swapchain_info.minImageCount = choose_image_count(caps);
     swapchain_info.imageFormat = swapchain_format;
     swapchain_info.imageColorSpace = swapchain_colorspace;
     swapchain_info.imageExtent = {(uint32_t)sw_width, (uint32_t)sw_height};
@@ -270,12 +1039,16 @@ static void recreate_swapchain(int new_width, int new_height) {
     swapchain_info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     swapchain_info.preTransform = caps.currentTransform;
     swapchain_info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    swapchain_info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    swapchain_info.presentMode = choose_present_mode();
     swapchain_info.clipped = VK_TRUE;
     swapchain_info.oldSwapchain = old_swapchain;
     check_vk(vkCreateSwapchainKHR(vk_device, &swapchain_info, nullptr, &vk_swapchain), "vkCreateSwapchainKHR");
 
-    vkDestroySwapchainKHR(vk_device, old_swapchain, nullptr);
+    retired_swapchains.push_back({old_swapchain, std::move(swapchain_views), std::move(render_complete),
+                                  frames_submitted});
+    swapchain_views.clear();
+    render_complete.clear();
+    image_fences.clear();
 
     uint32_t image_count = 0;
     vkGetSwapchainImagesKHR(vk_device, vk_swapchain, &image_count, nullptr);
@@ -292,17 +1065,23 @@ static void recreate_swapchain(int new_width, int new_height) {
         check_vk(vkCreateImageView(vk_device, &view_info, nullptr, &swapchain_views[i]), "vkCreateImageView");
     }
 
+    create_image_resources();
+    collect_retired_swapchains();
+
+    resize_stats.add(ms_since(start));
     fprintf(stderr, "*** Swapchain resized: %dx%d ***\n", sw_width, sw_height);
 }
 
 static void create_mpv_render() {
-    // Qt resets locale, set it again before mpv
-    setlocale(LC_NUMERIC, "C");
-
     mpv = mpv_create();
-    mpv_set_option_string(mpv, "vo", "libmpv");
     mpv_set_option_string(mpv, "terminal", "yes");
 
+    // Profile first, so it can't override what this renderer depends on
+    for (const MpvProfile::Option &option : activeMpvProfile().options)
+        mpv_set_option_string(mpv, option.first.constData(), option.second.constData());
+
+    mpv_set_option_string(mpv, "vo", "libmpv");
+
     // HDR settings - explicit for HDR10 swapchain
     mpv_set_option_string(mpv, "target-trc", "pq");
     mpv_set_option_string(mpv, "target-prim", "bt.2020");
@@ -310,11 +1089,22 @@ static void create_mpv_render() {
 
     mpv_initialize(mpv);
 
+    // Playback state for the event thread's snapshots
+    mpv_observe_property(mpv, 0, "pause", MPV_FORMAT_FLAG);
+    mpv_observe_property(mpv, 0, "time-pos", MPV_FORMAT_DOUBLE);
+    mpv_observe_property(mpv, 0, "container-fps", MPV_FORMAT_DOUBLE);
+    mpv_observe_property(mpv, 0, "vsync-jitter", MPV_FORMAT_DOUBLE);
+    mpv_observe_property(mpv, 0, "mistimed-frame-count", MPV_FORMAT_INT64);
+    mpv_observe_property(mpv, 0, "vo-delayed-frame-count", MPV_FORMAT_INT64);
+    mpv_observe_property(mpv, 0, "video-params", MPV_FORMAT_NODE);
+
     // Create render context
     mpv_vulkan_init_params vk_params = {};
     vk_params.instance = vk_instance;
     vk_params.physical_device = vk_physical_device;
     vk_params.device = vk_device;
+    // The handle, not an index: with a shared device this is queue 1 of the
+    // family, while Qt was given queue 0 through fromDeviceObjects
     vk_params.graphics_queue = vk_queue;
     vk_params.graphics_queue_family = vk_queue_family;
     vk_params.get_instance_proc_addr = vkGetInstanceProcAddr;
@@ -334,46 +1124,197 @@ static void create_mpv_render() {
         fprintf(stderr, "Failed to create mpv render context: %s\n", mpv_error_string(result));
         exit(1);
     }
+    mpv_render_context_set_update_callback(mpv_render, on_mpv_render_update, nullptr);
+    mpv_set_wakeup_callback(mpv, on_mpv_wakeup, nullptr);
     fprintf(stderr, "*** mpv render context created ***\n");
 }
 
+// Per-frame CPU timings, reported every few seconds
+struct FrameTimings {
+    int frames = 0;
+    double acquire_sum = 0, acquire_max = 0;
+    double submit_sum = 0, submit_max = 0;
+    int gpu_frames = 0;
+    double gpu_sum = 0, gpu_max = 0;
+
+    void add(double acquire_ms, double submit_ms) {
+        frames++;
+        acquire_sum += acquire_ms;
+        acquire_max = std::max(acquire_max, acquire_ms);
+        submit_sum += submit_ms;
+        submit_max = std::max(submit_max, submit_ms);
+    }
+
+    void add_gpu(double gpu_ms) {
+        if (gpu_ms < 0) return;
+        gpu_frames++;
+        gpu_sum += gpu_ms;
+        gpu_max = std::max(gpu_max, gpu_ms);
+    }
+
+    void report() {
+        if (frames == 0) return;
+        fprintf(stderr, "*** %d frames (%dx%d %s, %.1f MB/frame, in-flight=%d): acquire-wait avg %.2f ms (max %.2f), "
+                "render+submit avg %.2f ms (max %.2f), GPU avg %.2f ms (max %.2f) ***\n",
+                frames, sw_width, sw_height, native_size ? "native" : "window",
+                (double)sw_width * sw_height * bytes_per_pixel(swapchain_format) / (1024 * 1024), frames_in_flight,
+                acquire_sum / frames, acquire_max, submit_sum / frames, submit_max,
+                gpu_frames ? gpu_sum / gpu_frames : 0, gpu_max);
+        *this = FrameTimings();
+    }
+};
+
+// Render thread wakeups, to confirm idle/paused playback costs (almost) nothing
+struct WakeupCounters {
+    uint64_t wakeups = 0;
+    uint64_t frames = 0;
+    uint64_t idle = 0;
+
+    void report() {
+        fprintf(stderr, "*** Render thread: %llu wakeups, %llu update callbacks, %llu frames rendered, %llu idle ***\n",
+                (unsigned long long)wakeups, (unsigned long long)update_callbacks.exchange(0),
+                (unsigned long long)frames, (unsigned long long)idle);
+        *this = WakeupCounters();
+    }
+};
+
 static void render_loop() {
+    FrameTimings timings;
+    WakeupCounters counters;
+    auto next_report = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    bool redraw = true;
+    double last_gpu_ms = 0;
+
+    start_feedback_thread();
+
     while (running) {
-        // Check for resize
-        if (needs_resize) {
+        bool update = false;
+        {
+            std::unique_lock<std::mutex> lock(render_mutex);
+            if (!redraw) {
+                render_cv.wait_until(lock, next_report, [] {
+                    return !running || render_update_pending || needs_resize || swaps_pending > 0;
+                });
+            }
+            update = render_update_pending;
+            render_update_pending = false;
+        }
+        drain_swaps();
+
+        if (std::chrono::steady_clock::now() >= next_report) {
+            PlaybackState state = playback_snapshot();
+            collect_retired_swapchains();
+            timings.report();
+            report_presentation_stats(state.fps);
+            fprintf(stderr, "*** mpv timing: display-fps %.3f, vsync-jitter %.4f, mistimed %lld, vo-delayed %lld ***\n",
+                    display_fps.load(), state.vsync_jitter, (long long)state.mistimed_frames,
+                    (long long)state.delayed_frames);
+            resize_stats.report();
+            counters.report();
+            next_report = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        }
+
+        if (!running) break;
+        if (!update && !redraw && !needs_resize) continue;
+        counters.wakeups++;
+
+        // Coalesced resize: only the latest size is applied, at most once per presented frame
+        if (needs_resize.exchange(false)) {
             int w = pending_width;
             int h = pending_height;
-            if (w > 0 && h > 0) {
+            if (w > 0 && h > 0 && native_size) {
+                // Window resizes only move the viewport; video size changes rebuild
+                PlaybackState state = playback_snapshot();
+                update_viewport(w, h, state.video_width, state.video_height);
+                if (state.video_width > 0 && state.video_height > 0) {
+                    w = state.video_width;
+                    h = state.video_height;
+                }
+                redraw = true;
+            }
+            if (w > 0 && h > 0 && (w != sw_width || h != sw_height)) {
                 recreate_swapchain(w, h);
+                redraw = true;
             }
-            needs_resize = false;
         }
 
-        // Check mpv events
-        while (1) {
-            mpv_event *event = mpv_wait_event(mpv, 0);
-            if (event->event_id == MPV_EVENT_NONE) break;
-            if (event->event_id == MPV_EVENT_SHUTDOWN || event->event_id == MPV_EVENT_END_FILE)
-                running = false;
+        // Only render when mpv has a new frame, or the swapchain needs refilling
+        if (update || redraw) {
+            uint64_t flags = mpv_render_context_update(mpv_render);
+            if (flags & MPV_RENDER_UPDATE_FRAME)
+                redraw = true;
+        }
+        if (!redraw) {
+            counters.idle++;
+            continue;
+        }
+        redraw = false;
+
+        // When mpv wants this frame on screen, converted to the presentation clock
+        mpv_render_frame_info frame_info = {};
+        mpv_render_context_get_info(mpv_render, {MPV_RENDER_PARAM_NEXT_FRAME_INFO, &frame_info});
+        uint64_t target_ns = 0;
+        if (frame_info.target_time > 0) {
+            int64_t mpv_offset_ns = (int64_t)presentation_now_ns() - mpv_get_time_us(mpv) * 1000;
+            target_ns = (uint64_t)(frame_info.target_time * 1000 + mpv_offset_ns);
         }
 
-        if (!running) break;
+        // Render-late: start just early enough for the frame to make its vblank
+        if (latency_mode == LatencyMode::Late && frame_info.target_time > 0) {
+            int64_t wait_us = frame_info.target_time - mpv_get_time_us(mpv) - (int64_t)(render_budget_ms * 1000);
+            if (wait_us > 0) {
+                std::unique_lock<std::mutex> lock(render_mutex);
+                render_cv.wait_for(lock, std::chrono::microseconds(wait_us), [] {
+                    return !running || needs_resize;
+                });
+            }
+            if (!running) break;
+        }
 
-        // Acquire swapchain image
-        VkFence fence;
-        VkFenceCreateInfo fence_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
-        vkCreateFence(vk_device, &fence_info, nullptr, &fence);
+        // Wait only for the frame that last used this slot, so frame N+1 is
+        // recorded while the GPU is still busy with frame N
+        FrameSlot &slot = frame_slots[frames_submitted % frame_slots.size()];
+        auto acquire_start = std::chrono::steady_clock::now();
+        vkWaitForFences(vk_device, 1, &slot.in_flight, VK_TRUE, UINT64_MAX);
+        frames_completed = std::max(frames_completed, slot.serial);
+        double gpu_ms = read_slot_gpu_time(slot);
+        timings.add_gpu(gpu_ms);
+        if (gpu_ms >= 0)
+            last_gpu_ms = gpu_ms;
+        if (!retired_swapchains.empty())
+            collect_retired_swapchains();
 
         uint32_t image_idx;
-        VkResult result = vkAcquireNextImageKHR(vk_device, vk_swapchain, 1000000000, VK_NULL_HANDLE, fence, &image_idx);
+        VkResult result = vkAcquireNextImageKHR(vk_device, vk_swapchain, 1000000000, slot.image_acquired,
+                                                VK_NULL_HANDLE, &image_idx);
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            recreate_swapchain(sw_width, sw_height);
+            redraw = true;
+            continue;
+        }
         if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-            vkDestroyFence(vk_device, fence, nullptr);
             std::this_thread::sleep_for(std::chrono::milliseconds(16));
+            redraw = true;
             continue;
         }
 
-        vkWaitForFences(vk_device, 1, &fence, VK_TRUE, UINT64_MAX);
-        vkDestroyFence(vk_device, fence, nullptr);
+        // The image may still be owned by an older frame from another slot
+        if (image_fences[image_idx] != VK_NULL_HANDLE && image_fences[image_idx] != slot.in_flight)
+            vkWaitForFences(vk_device, 1, &image_fences[image_idx], VK_TRUE, UINT64_MAX);
+        image_fences[image_idx] = slot.in_flight;
+        double acquire_ms = ms_since(acquire_start);
+
+        auto submit_start = std::chrono::steady_clock::now();
+
+        // Make the queue wait for the acquired image before mpv's work
+        VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo wait_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        wait_info.waitSemaphoreCount = 1;
+        wait_info.pWaitSemaphores = &slot.image_acquired;
+        wait_info.pWaitDstStageMask = &wait_stage;
+        wait_info.commandBufferCount = 1;
+        wait_info.pCommandBuffers = &slot.begin_cmd;
+        vkQueueSubmit(vk_queue, 1, &wait_info, VK_NULL_HANDLE);
 
         // Render with mpv
         mpv_vulkan_fbo fbo = {};
@@ -385,31 +1326,198 @@ static void render_loop() {
         fbo.current_layout = VK_IMAGE_LAYOUT_UNDEFINED;
         fbo.target_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
+        // Pacing is done here (present mode or the late wait); mpv must not
+        // sleep until the target time again, or submit_ms absorbs that sleep
         int flip_y = 0;
+        int block_for_target = 0;
         mpv_render_param render_params[] = {
             {MPV_RENDER_PARAM_VULKAN_FBO, &fbo},
             {MPV_RENDER_PARAM_FLIP_Y, &flip_y},
+            {MPV_RENDER_PARAM_BLOCK_FOR_TARGET_TIME, &block_for_target},
             {MPV_RENDER_PARAM_INVALID, nullptr}
         };
 
         mpv_render_context_render(mpv_render, render_params);
 
+        // Signal render-complete and the slot fence once everything submitted so far is done
+        vkResetFences(vk_device, 1, &slot.in_flight);
+        VkSubmitInfo signal_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        signal_info.commandBufferCount = 1;
+        signal_info.pCommandBuffers = &slot.end_cmd;
+        signal_info.signalSemaphoreCount = 1;
+        signal_info.pSignalSemaphores = &render_complete[image_idx];
+        vkQueueSubmit(vk_queue, 1, &signal_info, slot.in_flight);
+        slot.serial = ++frames_submitted;
+        slot.timed = timestamp_pool != VK_NULL_HANDLE;
+
         // Present
         VkPresentInfoKHR present_info = {VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
+        present_info.waitSemaphoreCount = 1;
+        present_info.pWaitSemaphores = &render_complete[image_idx];
         present_info.swapchainCount = 1;
         present_info.pSwapchains = &vk_swapchain;
         present_info.pImageIndices = &image_idx;
+        bool feedback = request_presentation_feedback(target_ns);
         vkQueuePresentKHR(vk_queue, &present_info);
+        if (!feedback)
+            report_swap();
+
+        double submit_ms = ms_since(submit_start);
+        timings.add(acquire_ms, submit_ms);
+
+        // Budget for render-late: decaying max of CPU+GPU cost plus a safety margin
+        render_budget_ms = std::max(render_budget_ms * 0.95, submit_ms + last_gpu_ms + 2.0);
+        if (frames_submitted == 1) {
+            fprintf(stderr, "*** First video frame after %.1f ms, RSS %.1f MB (shared device: %s) ***\n",
+                    ms_since(startup_time), rss_mb(),
+                    shared_device ? "yes" : shared_device_fallback ? "NO, fell back - comparison invalid" : "no");
+        }
+        counters.frames++;
     }
 
+    vkDeviceWaitIdle(vk_device);
+    frames_completed = frames_submitted;
+    collect_retired_swapchains();
+    destroy_image_resources();
+    destroy_frame_resources();
+
+    stop_feedback_thread();
     mpv_render_context_free(mpv_render);
-    mpv_terminate_destroy(mpv);
+    mpv_render = nullptr;
+}
+
+static void handle_property_change(const mpv_event_property *prop, PlaybackState &state) {
+    if (strcmp(prop->name, "pause") == 0 && prop->format == MPV_FORMAT_FLAG) {
+        state.paused = *(int *)prop->data;
+    } else if (strcmp(prop->name, "time-pos") == 0) {
+        state.time_pos = prop->format == MPV_FORMAT_DOUBLE ? *(double *)prop->data : 0.0;
+    } else if (strcmp(prop->name, "container-fps") == 0) {
+        state.fps = prop->format == MPV_FORMAT_DOUBLE ? *(double *)prop->data : 0.0;
+    } else if (strcmp(prop->name, "vsync-jitter") == 0) {
+        state.vsync_jitter = prop->format == MPV_FORMAT_DOUBLE ? *(double *)prop->data : 0.0;
+    } else if (strcmp(prop->name, "mistimed-frame-count") == 0) {
+        state.mistimed_frames = prop->format == MPV_FORMAT_INT64 ? *(int64_t *)prop->data : 0;
+    } else if (strcmp(prop->name, "vo-delayed-frame-count") == 0) {
+        state.delayed_frames = prop->format == MPV_FORMAT_INT64 ? *(int64_t *)prop->data : 0;
+    } else if (strcmp(prop->name, "video-params") == 0) {
+        state.video_width = 0;
+        state.video_height = 0;
+        state.hdr = false;
+        if (prop->format != MPV_FORMAT_NODE) return;
+        const mpv_node *node = (const mpv_node *)prop->data;
+        if (node->format != MPV_FORMAT_NODE_MAP) return;
+        for (int i = 0; i < node->u.list->num; i++) {
+            const char *key = node->u.list->keys[i];
+            const mpv_node &value = node->u.list->values[i];
+            if (strcmp(key, "dw") == 0 && value.format == MPV_FORMAT_INT64) {
+                state.video_width = (int)value.u.int64;
+            } else if (strcmp(key, "dh") == 0 && value.format == MPV_FORMAT_INT64) {
+                state.video_height = (int)value.u.int64;
+            } else if (strcmp(key, "gamma") == 0 && value.format == MPV_FORMAT_STRING) {
+                state.hdr = strcmp(value.u.string, "pq") == 0 || strcmp(value.u.string, "hlg") == 0;
+            }
+        }
+    }
+}
+
+static void publish_playback_state(const PlaybackState &state) {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        playback_state = state;
+    }
+
+    // At most one queued GUI update; it always picks up the latest snapshot
+    if (gui_state && !gui_update_queued.exchange(true)) {
+        QMetaObject::invokeMethod(gui_state, [] {
+            gui_update_queued = false;
+            gui_state->update(playback_snapshot());
+        }, Qt::QueuedConnection);
+    }
+}
+
+static void event_loop() {
+    bool quit_requested = false;
+
+    while (event_running) {
+        {
+            std::unique_lock<std::mutex> lock(event_mutex);
+            event_cv.wait(lock, [] { return event_pending || !event_running; });
+            event_pending = false;
+        }
+
+        PlaybackState state = playback_snapshot();
+        int video_width = state.video_width, video_height = state.video_height;
+        bool changed = false;
+        while (1) {
+            mpv_event *event = mpv_wait_event(mpv, 0);
+            if (event->event_id == MPV_EVENT_NONE) break;
+            if (event->event_id == MPV_EVENT_PROPERTY_CHANGE) {
+                handle_property_change((mpv_event_property *)event->data, state);
+                changed = true;
+            } else if (event->event_id == MPV_EVENT_SHUTDOWN || event->event_id == MPV_EVENT_END_FILE) {
+                state.ended = true;
+                changed = true;
+            } else if (event->event_id == MPV_EVENT_COMMAND_REPLY && event->error < 0) {
+                // loadfile is issued async by the startup worker
+                fprintf(stderr, "*** mpv command failed: %s ***\n", mpv_error_string(event->error));
+            }
+        }
+        if (changed) publish_playback_state(state);
+
+        // Native size mode sizes the swapchain from video-params
+        if (native_size && (state.video_width != video_width || state.video_height != video_height)) {
+            needs_resize = true;
+            wake_render_thread();
+        }
+
+        // Hand shutdown to the GUI thread; it stops the render thread between frames
+        if (state.ended && !quit_requested) {
+            quit_requested = true;
+            QMetaObject::invokeMethod(qApp, "quit", Qt::QueuedConnection);
+        }
+    }
+}
+
+// Benchmark: replay a scripted drag-resize, one size step per 8 ms
+static void start_resize_storm(QQuickWindow *window) {
+    static const QSize sizes[] = {
+        {1280, 720}, {1920, 1080}, {800, 600}, {2560, 1440}, {1024, 768}, {1600, 900},
+    };
+    const int steps_per_leg = 30;
+    const int legs = sizeof(sizes) / sizeof(sizes[0]) - 1;
+
+    auto *timer = new QTimer(window);
+    auto step = std::make_shared<int>(0);
+    auto start = std::make_shared<std::chrono::steady_clock::time_point>();
+    QObject::connect(timer, &QTimer::timeout, window, [=]() {
+        if (*step == 0) *start = std::chrono::steady_clock::now();
+        int leg = *step / steps_per_leg;
+        if (leg >= legs) {
+            timer->stop();
+            timer->deleteLater();
+            fprintf(stderr, "*** Resize storm done: %d size changes in %.0f ms ***\n",
+                    *step, ms_since(*start));
+            return;
+        }
+        double t = (double)(*step % steps_per_leg) / steps_per_leg;
+        const QSize &from = sizes[leg];
+        const QSize &to = sizes[leg + 1];
+        window->resize(from.width() + (int)((to.width() - from.width()) * t),
+                       from.height() + (int)((to.height() - from.height()) * t));
+        (*step)++;
+    });
+    // Give startup a moment so the storm measures steady-state rebuilds
+    QTimer::singleShot(2000, timer, [timer]() { timer->start(8); });
+    fprintf(stderr, "*** Resize storm scheduled: %d steps ***\n", legs * steps_per_leg);
 }
 
 // Forward declarations for setup after window is ready
 static void setup_mpv_subsurface(QQuickWindow *window, const char *videoFile);
 
 int main(int argc, char *argv[]) {
+    startup_time = std::chrono::steady_clock::now();
+    activeMpvProfile() = mpvProfileFromArguments(argc, argv);
+
     if (argc < 2) {
         fprintf(stderr, "Usage: %s <video-file>\n", argv[0]);
         return 1;
@@ -418,6 +1526,13 @@ int main(int argc, char *argv[]) {
     // mpv requires C locale
     setlocale(LC_NUMERIC, "C");
 
+    fprintf(stderr, "*** mpv profile: %s ***\n", activeMpvProfile().describe().constData());
+
+    frames_in_flight = std::clamp(env_int("MPV_OVERLAY_FRAMES_IN_FLIGHT", 2), 1, 4);
+    native_size = env_int("MPV_OVERLAY_NATIVE_SIZE", 0) != 0;
+    shared_device = env_int("MPV_OVERLAY_SHARED_DEVICE", 0) != 0;
+    latency_mode = parse_latency_mode(getenv("MPV_OVERLAY_LATENCY"));
+
     // Must initialize QtWebEngine before QGuiApplication
     QtWebEngineQuick::initialize();
 
@@ -426,13 +1541,8 @@ int main(int argc, char *argv[]) {
 
     QGuiApplication app(argc, argv);
 
-    // Create QVulkanInstance for Qt (separate from mpv's Vulkan context)
-    QVulkanInstance vulkanInstance;
-    vulkanInstance.setApiVersion(QVersionNumber(1, 2));
-    if (!vulkanInstance.create()) {
-        fprintf(stderr, "Failed to create Qt Vulkan instance\n");
-        return 1;
-    }
+    // Qt resets locale, set it again before the startup worker creates mpv
+    setlocale(LC_NUMERIC, "C");
 
     // Get Wayland display from Qt
     QPlatformNativeInterface *native = QGuiApplication::platformNativeInterface();
@@ -454,11 +1564,44 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    // Qt's Vulkan instance: separate from mpv's, or adopting it when sharing the device
+    QVulkanInstance vulkanInstance;
+    vulkanInstance.setApiVersion(QVersionNumber(1, 2));
+    if (shared_device) {
+        create_vulkan_device();
+        vulkanInstance.setVkInstance(vk_instance);
+    }
+    if (!vulkanInstance.create()) {
+        fprintf(stderr, "Failed to create Qt Vulkan instance\n");
+        return 1;
+    }
+
     // Create QML engine
     QQmlApplicationEngine engine;
 
     const char *videoFile = argv[1];
     std::thread *render_thread = nullptr;
+    std::thread *event_thread = nullptr;
+
+    // Vulkan device, mpv initialization and file open/demux run on a worker
+    // in parallel with QML/WebEngine startup; joined once the subsurface exists
+    std::thread startup_thread([videoFile]() {
+        auto start = std::chrono::steady_clock::now();
+        if (!vk_device)
+            create_vulkan_device();
+        create_frame_resources();
+        create_mpv_render();
+
+        // Async so demuxing overlaps with the rest of startup
+        const char *cmd[] = {"loadfile", videoFile, nullptr};
+        mpv_command_async(mpv, 0, cmd);
+        fprintf(stderr, "*** Startup worker done in %.1f ms (at %.1f ms) ***\n",
+                ms_since(start), ms_since(startup_time));
+    });
+
+    PlayerState playerState;
+    gui_state = &playerState;
+    engine.rootContext()->setContextProperty("playerState", &playerState);
 
     // Connect to window creation to set up subsurface and mpv
     QObject::connect(&engine, &QQmlApplicationEngine::objectCreated, [&](QObject *obj, const QUrl &) {
@@ -466,9 +1609,21 @@ int main(int argc, char *argv[]) {
 
         QQuickWindow *window = qobject_cast<QQuickWindow*>(obj);
         if (!window) return;
+        qt_window = window;
 
         // Set Qt's Vulkan instance on the window
         window->setVulkanInstance(&vulkanInstance);
+        if (shared_device) {
+            // Qt renders on queue 0, mpv on queue 1 of the same family
+            window->setGraphicsDevice(QQuickGraphicsDevice::fromDeviceObjects(
+                vk_physical_device, vk_device, vk_queue_family, 0));
+        }
+
+        // Time to first overlay paint, independent of when video shows up
+        QObject::connect(window, &QQuickWindow::frameSwapped, window, []() {
+            if (!first_overlay_frame.exchange(true))
+                fprintf(stderr, "*** First overlay frame after %.1f ms ***\n", ms_since(startup_time));
+        }, Qt::DirectConnection);
 
         // Process events to ensure window is mapped
         app.processEvents();
@@ -494,44 +1649,68 @@ int main(int argc, char *argv[]) {
         // Desync mode - subsurface updates independently
         wl_subsurface_set_desync(mpv_subsurface);
 
+        if (native_size)
+            create_native_size_surfaces(qt_surface);
+
         wl_surface_commit(mpv_surface);
         wl_display_roundtrip(wl_display);
+        create_presentation_feedback();
 
         fprintf(stderr, "*** Created mpv subsurface below Qt ***\n");
 
         // Get window size
         sw_width = window->width();
         sw_height = window->height();
+        pending_width = sw_width;
+        pending_height = sw_height;
         fprintf(stderr, "*** Window size: %dx%d ***\n", sw_width, sw_height);
 
-        // Create Vulkan context and swapchain for mpv surface
-        create_vulkan_for_mpv();
-        create_swapchain();
-        create_mpv_render();
+        // The swapchain needs both the worker's device and our subsurface
+        auto join_start = std::chrono::steady_clock::now();
+        startup_thread.join();
+        fprintf(stderr, "*** Waited %.1f ms for startup worker ***\n", ms_since(join_start));
 
-        // Load video
-        const char *cmd[] = {"loadfile", videoFile, nullptr};
-        mpv_command(mpv, cmd);
+        create_vulkan_surface();
+        create_swapchain();
 
-        // Handle window resize
-        QObject::connect(window, &QWindow::widthChanged, [window](int) {
+        // Handle window resize; the render thread only picks up the latest size
+        auto request_resize = [window]() {
             pending_width = window->width();
             pending_height = window->height();
             needs_resize = true;
-        });
-        QObject::connect(window, &QWindow::heightChanged, [window](int) {
-            pending_width = window->width();
-            pending_height = window->height();
-            needs_resize = true;
-        });
+            wake_render_thread();
+        };
+        QObject::connect(window, &QWindow::widthChanged, request_resize);
+        QObject::connect(window, &QWindow::heightChanged, request_resize);
 
-        // Start render thread
+        // QScreen refresh rate until presentation feedback reports the real one
+        auto update_screen_fps = [window]() {
+            if (!feedback_refresh_known && window->screen())
+                set_display_fps(window->screen()->refreshRate(), "QScreen");
+        };
+        // Only the current screen's refresh rate matters; drop the previous one's
+        auto screen_connection = std::make_shared<QMetaObject::Connection>();
+        auto watch_screen = [window, update_screen_fps, screen_connection](QScreen *screen) {
+            QObject::disconnect(*screen_connection);
+            if (screen)
+                *screen_connection = QObject::connect(screen, &QScreen::refreshRateChanged, window, update_screen_fps);
+            update_screen_fps();
+        };
+        QObject::connect(window, &QWindow::screenChanged, window, watch_screen);
+        watch_screen(window->screen());
+
+        if (env_int("MPV_OVERLAY_RESIZE_STORM", 0))
+            start_resize_storm(window);
+
+        // Start event and render threads
+        event_thread = new std::thread(event_loop);
         render_thread = new std::thread(render_loop);
     });
 
     // Handle app quit
     QObject::connect(&app, &QGuiApplication::aboutToQuit, [&]() {
         running = false;
+        wake_render_thread();
     });
 
     // Load QML
@@ -539,11 +1718,37 @@ int main(int argc, char *argv[]) {
 
     int ret = app.exec();
 
+    if (startup_thread.joinable())
+        startup_thread.join();
+
     running = false;
+    wake_render_thread();
     if (render_thread) {
         render_thread->join();
         delete render_thread;
+    } else if (mpv_render) {
+        // Window setup failed before render_loop started; free what it would
+        // have, since mpv_terminate_destroy with a live render context is undefined
+        destroy_frame_resources();
+        mpv_render_context_free(mpv_render);
+        mpv_render = nullptr;
+    }
+
+    event_running = false;
+    {
+        std::lock_guard<std::mutex> lock(event_mutex);
+    }
+    event_cv.notify_one();
+    if (event_thread) {
+        event_thread->join();
+        delete event_thread;
     }
+    gui_state = nullptr;
+
+    if (mpv)
+        mpv_terminate_destroy(mpv);
 
     return ret;
 }
+
+#include "main.moc"
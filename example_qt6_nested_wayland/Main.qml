@@ -3,6 +3,7 @@ import QtQuick.Controls
 import QtWebEngine
 import QtWayland.Compositor
 import QtWayland.Compositor.XdgShell
+import Example.Compositor
 
 WaylandCompositor {
     id: compositor
@@ -29,6 +30,7 @@ WaylandCompositor {
         onToplevelCreated: (toplevel, xdgSurface) => {
             mpvSurfaceItem.surface = xdgSurface.surface
             compositor.mpvToplevel = toplevel
+            toplevelSizer.attach(toplevel, xdgSurface.surface, mainWindow.width, mainWindow.height)
         }
     }
 
@@ -38,23 +40,17 @@ WaylandCompositor {
 
     ApplicationWindow {
         id: mainWindow
-        width: 1280
-        height: 720
+        width: benchmark4k ? 3840 : 1280
+        height: benchmark4k ? 2160 : 720
         visible: true
         title: "mpv with Qt WebEngine Overlay (Qt6 Nested Wayland)"
         color: "#000000"
 
-        onWidthChanged: handleResize()
-        onHeightChanged: handleResize()
+        // Coalesced into xdg_toplevel configures, one outstanding at a time
+        onWidthChanged: toplevelSizer.resize(mainWindow.width, mainWindow.height)
+        onHeightChanged: toplevelSizer.resize(mainWindow.width, mainWindow.height)
 
-        property bool resizedSinceTick: false
-
-        function handleResize() {
-            if (!mpvSurfaceItem.surface) return
-            mpvLauncher.resize(mainWindow.width, mainWindow.height)
-        }
-
-        WaylandQuickItem {
+        DamageSurfaceItem {
             id: mpvSurfaceItem
             anchors.centerIn: parent
 
@@ -70,7 +66,20 @@ WaylandCompositor {
             inputEventsEnabled: true
             focusOnClick: true
             focus: true
-            layer.enabled: true
+            layer.enabled: layersEnabled
+        }
+
+        // Playback stats from properties mpv streams over IPC
+        Text {
+            anchors.left: parent.left
+            anchors.bottom: parent.bottom
+            anchors.margins: 8
+            z: 101
+            color: "#cccccc"
+            font.pixelSize: 12
+            text: "time " + Number(mpvLauncher.observed["time-pos"] || 0).toFixed(1) + "s"
+                  + "  drops " + (mpvLauncher.observed["frame-drop-count"] || 0)
+                  + (mpvLauncher.observed["paused-for-cache"] ? "  buffering" : "")
         }
 
         WebEngineView {
@@ -79,7 +88,7 @@ WaylandCompositor {
             z: 100
             backgroundColor: "transparent"
             settings.showScrollBars: false
-            layer.enabled: true
+            layer.enabled: layersEnabled
 
             url: "data:text/html," + encodeURIComponent(`
 <!DOCTYPE html>
@@ -132,37 +141,17 @@ WaylandCompositor {
             `)
         }
 
-        MouseArea {
-            id: inputArea
-            anchors.fill: parent
-            z: 200
-            hoverEnabled: true
-            acceptedButtons: Qt.AllButtons
-
-            Component.onCompleted: {
-                inputForwarder.seat = compositor.defaultSeat
-                inputForwarder.target = mpvSurfaceItem
-            }
-
-            onPositionChanged: (mouse) => {
-                inputForwarder.mouseMove(mouse.x, mouse.y)
-            }
-
-            onPressed: (mouse) => {
-                inputForwarder.mousePress(mouse.button)
-            }
-
-            onReleased: (mouse) => {
-                inputForwarder.mouseRelease(mouse.button)
-            }
-
-            onWheel: (wheel) => {
-                inputForwarder.mouseWheel(Qt.Vertical, wheel.angleDelta.y)
-            }
-        }
-
         Component.onCompleted: {
-            mpvLauncher.start()
+            // Pointer input goes to mpv through InputForwarder's event filter on this window
+            inputForwarder.seat = compositor.defaultSeat
+            inputForwarder.target = mpvSurfaceItem
+            mpvLauncher.start(mainWindow.width, mainWindow.height)
+            // Streamed over IPC for the stats line; queued until mpv's socket is up
+            mpvLauncher.observe("time-pos")
+            mpvLauncher.observe("paused-for-cache")
+            mpvLauncher.observe("frame-drop-count")
+            if (resizeStorm)
+                toplevelSizer.startResizeStorm(mainWindow)
         }
 
         Component.onDestruction: {
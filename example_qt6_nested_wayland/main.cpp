@@ -3,7 +3,11 @@
 #include <QQmlContext>
 #include <QProcess>
 #include <QTimer>
+#include <QPointer>
 #include <QLocalSocket>
+#include <QFileSystemWatcher>
+#include <QFileInfo>
+#include <QHash>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
@@ -12,10 +16,31 @@
 #include <QWaylandQuickItem>
 #include <QWaylandCompositor>
 #include <QWaylandViewporter>
+#include <QWaylandXdgShell>
+#include <QWaylandBufferRef>
+#include <QWaylandSurface>
+#include <QWaylandView>
 #include <QQuickWindow>
-
+#include <QScreen>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QSGSimpleTextureNode>
+#include <QSGTexture>
+#include <QElapsedTimer>
+#include <rhi/qrhi.h>
+
+#include <atomic>
 #include <cstdio>
+#include <functional>
+#include <memory>
+
+#include "mpvprofile.h"
 
+// Forwards the window's pointer input straight to the seat from an event
+// filter, with no QML in the path. Motion is compressed to the latest position
+// and wheel deltas are summed, both flushed once per frame (afterAnimating);
+// presses and releases flush pending motion first so they land where the
+// pointer is. Logs events in/out per second and GUI-thread input time every 5s.
 class InputForwarder : public QObject
 {
     Q_OBJECT
@@ -23,36 +48,68 @@ class InputForwarder : public QObject
     Q_PROPERTY(QWaylandQuickItem* target READ target WRITE setTarget NOTIFY targetChanged)
 
 public:
-    explicit InputForwarder(QObject* parent = nullptr) : QObject(parent), m_seat(nullptr), m_target(nullptr) {}
+    explicit InputForwarder(QObject* parent = nullptr) : QObject(parent), m_seat(nullptr), m_target(nullptr) {
+        // Fallback for when no frame is coming: flush one refresh interval later
+        m_flushTimer.setSingleShot(true);
+        m_flushTimer.setTimerType(Qt::PreciseTimer);
+        connect(&m_flushTimer, &QTimer::timeout, this, &InputForwarder::flushPending);
+    }
 
     QWaylandSeat* seat() const { return m_seat; }
     void setSeat(QWaylandSeat* s) { if (m_seat != s) { m_seat = s; emit seatChanged(); } }
 
     QWaylandQuickItem* target() const { return m_target; }
-    void setTarget(QWaylandQuickItem* t) { if (m_target != t) { m_target = t; emit targetChanged(); } }
-
-    Q_INVOKABLE void mouseMove(qreal x, qreal y) {
-        if (m_seat && m_target && m_target->view()) {
-            m_seat->sendMouseMoveEvent(m_target->view(), QPointF(x, y));
+    void setTarget(QWaylandQuickItem* t) {
+        if (m_target == t) return;
+        if (m_target) disconnect(m_target, nullptr, this, nullptr);
+        m_target = t;
+        if (m_target) {
+            connect(m_target, &QQuickItem::windowChanged, this, &InputForwarder::setWindow);
+            setWindow(m_target->window());
         }
+        emit targetChanged();
     }
 
-    Q_INVOKABLE void mousePress(int button) {
-        if (m_seat) {
-            m_seat->sendMousePressEvent(static_cast<Qt::MouseButton>(button));
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override {
+        if (watched != m_window) return false;
+        switch (event->type()) {
+        case QEvent::MouseMove:
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseButtonRelease:
+        case QEvent::MouseButtonDblClick:
+        case QEvent::Wheel:
+            break;
+        default:
+            return false;
         }
-    }
 
-    Q_INVOKABLE void mouseRelease(int button) {
-        if (m_seat) {
-            m_seat->sendMouseReleaseEvent(static_cast<Qt::MouseButton>(button));
-        }
-    }
-
-    Q_INVOKABLE void mouseWheel(int orientation, int delta) {
-        if (m_seat) {
-            m_seat->sendMouseWheelEvent(static_cast<Qt::Orientation>(orientation), delta);
+        QElapsedTimer timer;
+        timer.start();
+        m_received++;
+        if (event->type() == QEvent::Wheel) {
+            m_wheel += static_cast<QWheelEvent*>(event)->angleDelta();
+            scheduleFlush();
+        } else {
+            auto* mouse = static_cast<QMouseEvent*>(event);
+            m_position = mouse->scenePosition();
+            m_motionPending = true;
+            if (event->type() == QEvent::MouseMove) {
+                scheduleFlush();
+            } else {
+                // Double clicks also arrive as a press, which is all the client needs
+                flush();
+                if (m_seat && event->type() == QEvent::MouseButtonPress) {
+                    m_seat->sendMousePressEvent(mouse->button());
+                    m_delivered++;
+                } else if (m_seat && event->type() == QEvent::MouseButtonRelease) {
+                    m_seat->sendMouseReleaseEvent(mouse->button());
+                    m_delivered++;
+                }
+            }
         }
+        m_inputNs += timer.nsecsElapsed();
+        return true;
     }
 
 Q_SIGNALS:
@@ -60,8 +117,81 @@ Q_SIGNALS:
     void targetChanged();
 
 private:
+    void setWindow(QQuickWindow* window) {
+        if (m_window == window) return;
+        if (m_window) {
+            m_window->removeEventFilter(this);
+            disconnect(m_window, nullptr, this, nullptr);
+        }
+        m_window = window;
+        if (!m_window) return;
+        m_window->installEventFilter(this);
+        // Frames the scene already renders (mpv's video, animations) carry the input
+        connect(m_window, &QQuickWindow::afterAnimating, this, &InputForwarder::flushPending);
+    }
+
+    // Motion and wheel wait for the next frame rather than forcing one
+    void scheduleFlush() {
+        if (m_flushTimer.isActive() || !m_window) return;
+        QScreen* screen = m_window->screen();
+        qreal hz = screen && screen->refreshRate() > 0 ? screen->refreshRate() : 60;
+        m_flushTimer.start(qMax(1, qRound(1000.0 / hz)));
+    }
+
+    void flushPending() {
+        QElapsedTimer timer;
+        timer.start();
+        m_flushTimer.stop();
+        flush();
+        m_inputNs += timer.nsecsElapsed();
+        report();
+    }
+
+    void flush() {
+        if (!m_seat || !m_target || !m_target->view()) return;
+        if (m_motionPending) {
+            m_motionPending = false;
+            QPointF local = m_target->mapToSurface(m_target->mapFromScene(m_position));
+            m_seat->sendMouseMoveEvent(m_target->view(), local, m_position);
+            m_delivered++;
+        }
+        if (m_wheel.y()) {
+            m_seat->sendMouseWheelEvent(Qt::Vertical, m_wheel.y());
+            m_delivered++;
+        }
+        if (m_wheel.x()) {
+            m_seat->sendMouseWheelEvent(Qt::Horizontal, m_wheel.x());
+            m_delivered++;
+        }
+        m_wheel = QPoint();
+    }
+
+    void report() {
+        if (!m_reportTimer.isValid())
+            m_reportTimer.start();
+        qint64 ms = m_reportTimer.elapsed();
+        if (ms < 5000) return;
+        if (m_received)
+            qDebug("input: %.0f events/s in, %.0f/s delivered, %.3f ms/s GUI thread",
+                   m_received * 1000.0 / ms, m_delivered * 1000.0 / ms, m_inputNs / 1e6 * 1000.0 / ms);
+        m_received = m_delivered = 0;
+        m_inputNs = 0;
+        m_reportTimer.restart();
+    }
+
     QWaylandSeat* m_seat;
     QWaylandQuickItem* m_target;
+    QPointer<QQuickWindow> m_window;
+
+    QPointF m_position;
+    bool m_motionPending = false;
+    QPoint m_wheel;
+    QTimer m_flushTimer;
+
+    QElapsedTimer m_reportTimer;
+    qint64 m_received = 0;
+    qint64 m_delivered = 0;
+    qint64 m_inputNs = 0;
 };
 
 class ViewporterHelper : public QObject
@@ -80,27 +210,394 @@ private:
     QWaylandViewporter* m_viewporter;
 };
 
+// Sizes mpv's toplevel with xdg_toplevel configures (maximized, so mpv takes
+// the size as given). At most one configure is outstanding: the next one goes
+// out when mpv commits a buffer of the configured size, so a resize storm
+// costs one buffer reallocation per client round trip, not one per step.
+class ToplevelSizer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ToplevelSizer(QObject* parent = nullptr) : QObject(parent)
+    {
+        m_timeout.setSingleShot(true);
+        m_timeout.setInterval(200);
+        connect(&m_timeout, &QTimer::timeout, this, [this]() {
+            // Clients may pick another size; don't wait on it forever
+            m_outstanding = false;
+            sendPending();
+        });
+        m_reportTimer.setSingleShot(true);
+        m_reportTimer.setInterval(1000);
+        connect(&m_reportTimer, &QTimer::timeout, this, &ToplevelSizer::report);
+    }
+
+    Q_INVOKABLE void attach(QWaylandXdgToplevel* toplevel, QWaylandSurface* surface, int width, int height) {
+        // mpv may recreate its toplevel; only the current surface's commits count
+        if (m_surface)
+            disconnect(m_surface, nullptr, this, nullptr);
+        m_toplevel = toplevel;
+        m_surface = surface;
+        m_bufferSize = surface->bufferSize();
+        m_configured = QSize();
+        connect(surface, &QWaylandSurface::redraw, this, &ToplevelSizer::surfaceCommitted);
+        m_pending = QSize(width, height);
+        m_outstanding = false;
+        sendPending();
+    }
+
+    Q_INVOKABLE void resize(int width, int height) {
+        m_requests++;
+        m_pending = QSize(width, height);
+        sendPending();
+        m_reportTimer.start();
+    }
+
+    // Scripted drag-resize (MPV_OVERLAY_RESIZE_STORM=1)
+    Q_INVOKABLE void startResizeStorm(QQuickWindow* window) {
+        static const QSize sizes[] = {
+            {1280, 720}, {1920, 1080}, {800, 600}, {2560, 1440}, {1024, 768}, {1600, 900},
+        };
+        const int stepsPerLeg = 30;
+        const int legs = sizeof(sizes) / sizeof(sizes[0]) - 1;
+
+        auto* timer = new QTimer(window);
+        auto step = std::make_shared<int>(0);
+        connect(timer, &QTimer::timeout, window, [=]() {
+            int leg = *step / stepsPerLeg;
+            if (leg >= legs) {
+                timer->stop();
+                timer->deleteLater();
+                return;
+            }
+            double t = double(*step % stepsPerLeg) / stepsPerLeg;
+            const QSize& from = sizes[leg];
+            const QSize& to = sizes[leg + 1];
+            window->resize(from.width() + int((to.width() - from.width()) * t),
+                           from.height() + int((to.height() - from.height()) * t));
+            (*step)++;
+        });
+        // Let mpv start first so the storm measures steady-state reallocations
+        QTimer::singleShot(2000, timer, [timer]() { timer->start(8); });
+        qDebug("Resize storm scheduled: %d steps", legs * stepsPerLeg);
+    }
+
+private:
+    void sendPending() {
+        if (!m_toplevel || m_outstanding || !m_pending.isValid() || m_pending == m_configured) return;
+        m_configured = m_pending;
+        m_toplevel->sendMaximized(m_configured);
+        m_configures++;
+        m_outstanding = true;
+        m_timeout.start();
+    }
+
+    void surfaceCommitted() {
+        if (!m_surface) return;
+        if (m_surface->bufferSize() != m_bufferSize) {
+            m_bufferSize = m_surface->bufferSize();
+            m_reallocations++;
+        }
+        if (m_outstanding && m_surface->destinationSize() == m_configured) {
+            m_outstanding = false;
+            m_timeout.stop();
+            sendPending();
+        }
+    }
+
+    void report() {
+        qDebug("resize: %d size changes, %d configures, %d buffer reallocations",
+               m_requests, m_configures, m_reallocations);
+        m_requests = m_configures = m_reallocations = 0;
+    }
+
+    QPointer<QWaylandXdgToplevel> m_toplevel;
+    QPointer<QWaylandSurface> m_surface;
+    QSize m_pending;
+    QSize m_configured;
+    QSize m_bufferSize;
+    bool m_outstanding = false;
+    QTimer m_timeout;
+    QTimer m_reportTimer;
+    int m_requests = 0;
+    int m_configures = 0;
+    int m_reallocations = 0;
+};
+
+// Upload accounting shared by all ShmTextures; render thread
+struct UploadStats
+{
+    std::atomic<qint64> uploads{0};
+    std::atomic<qint64> bytes{0};
+    std::atomic<qint64> fullBytes{0};  // what a whole-buffer upload would have cost
+};
+static UploadStats uploadStats;
+
+// Texture for a wl_shm buffer that persists across commits and only uploads
+// the damaged rects. The upload is merged into the scene graph's own resource
+// batch through commitTextureOperations.
+class ShmTexture : public QSGTexture
+{
+public:
+    ~ShmTexture() override { delete m_texture; }
+
+    // Render thread, GUI thread blocked
+    void setBuffer(const QWaylandBufferRef& ref, const QRegion& damage) {
+        m_ref = ref;  // keeps the client from reusing the memory until the next commit
+        m_image = ref.image();
+        QRect bounds(QPoint(), m_image.size());
+        if (m_image.size() != m_size) {
+            m_size = m_image.size();
+            m_dirty = bounds;
+        } else {
+            m_dirty += damage & bounds;
+        }
+    }
+
+    const QWaylandBufferRef& buffer() const { return m_ref; }
+
+    qint64 comparisonKey() const override { return qint64(quintptr(this)); }
+    QRhiTexture* rhiTexture() const override { return m_texture; }
+    QSize textureSize() const override { return m_size; }
+    bool hasAlphaChannel() const override { return m_image.hasAlphaChannel(); }
+    bool hasMipmaps() const override { return false; }
+
+    void commitTextureOperations(QRhi* rhi, QRhiResourceUpdateBatch* updates) override {
+        if (m_dirty.isEmpty() || m_image.isNull())
+            return;
+
+        // XRGB/ARGB8888 shm is BGRA in memory and XBGR/ABGR8888 is RGBA, so both
+        // upload as-is; anything else is converted, but only inside the damage
+        bool bgra = m_image.format() == QImage::Format_RGB32
+                 || m_image.format() == QImage::Format_ARGB32
+                 || m_image.format() == QImage::Format_ARGB32_Premultiplied;
+        bool rgba = m_image.format() == QImage::Format_RGBX8888
+                 || m_image.format() == QImage::Format_RGBA8888
+                 || m_image.format() == QImage::Format_RGBA8888_Premultiplied;
+        QRhiTexture::Format format = bgra && rhi->isTextureFormatSupported(QRhiTexture::BGRA8)
+                                   ? QRhiTexture::BGRA8 : QRhiTexture::RGBA8;
+        bool direct = format == QRhiTexture::BGRA8 ? bgra : rgba;
+
+        if (!m_texture || m_texture->pixelSize() != m_size || m_texture->format() != format) {
+            delete m_texture;
+            m_texture = rhi->newTexture(format, m_size);
+            if (!m_texture->create()) {
+                qWarning("Could not create %dx%d texture for shm buffer", m_size.width(), m_size.height());
+                delete m_texture;
+                m_texture = nullptr;
+                return;
+            }
+            m_dirty = QRect(QPoint(), m_size);
+        }
+
+        QList<QRhiTextureUploadEntry> entries;
+        qint64 bytes = 0;
+        for (const QRect& rect : m_dirty) {
+            QRhiTextureSubresourceUploadDescription desc;
+            if (direct) {
+                desc = QRhiTextureSubresourceUploadDescription(m_image);
+                desc.setSourceTopLeft(rect.topLeft());
+                desc.setSourceSize(rect.size());
+            } else {
+                desc = QRhiTextureSubresourceUploadDescription(
+                    m_image.copy(rect).convertToFormat(QImage::Format_RGBA8888));
+            }
+            desc.setDestinationTopLeft(rect.topLeft());
+            entries.append(QRhiTextureUploadEntry(0, 0, desc));
+            bytes += qint64(rect.width()) * rect.height() * 4;
+        }
+        QRhiTextureUploadDescription description;
+        description.setEntries(entries.cbegin(), entries.cend());
+        updates->uploadTexture(m_texture, description);
+        m_dirty = QRegion();
+
+        uploadStats.uploads++;
+        uploadStats.bytes += bytes;
+        uploadStats.fullBytes += qint64(m_size.width()) * m_size.height() * 4;
+    }
+
+private:
+    QWaylandBufferRef m_ref;
+    QImage m_image;
+    QSize m_size;
+    QRegion m_dirty;
+    QRhiTexture* m_texture = nullptr;
+};
+
+// WaylandQuickItem that draws wl_shm buffers through a ShmTexture instead of
+// a fresh texture with a full upload per commit. Other buffer types, and
+// everything with MPV_OVERLAY_FULL_UPLOAD=1, go through the stock path.
+// Also logs upload bytes/frame and compositor frame time every 5s.
+class DamageSurfaceItem : public QWaylandQuickItem
+{
+    Q_OBJECT
+
+public:
+    explicit DamageSurfaceItem(QQuickItem* parent = nullptr)
+        : QWaylandQuickItem(parent)
+        , m_fullUpload(qEnvironmentVariableIntValue("MPV_OVERLAY_FULL_UPLOAD") != 0)
+    {
+        connect(this, &QWaylandQuickItem::surfaceChanged, this, &DamageSurfaceItem::trackSurface);
+        connect(this, &QQuickItem::windowChanged, this, &DamageSurfaceItem::trackWindow);
+    }
+
+protected:
+    QSGNode* updatePaintNode(QSGNode* oldNode, UpdatePaintNodeData* data) override {
+        QWaylandBufferRef ref = view() ? view()->currentBuffer() : QWaylandBufferRef();
+        if (ref.hasContent())
+            m_importedBuffers = !ref.isSharedMemory();
+        bool ours = !m_fullUpload && isPaintEnabled() && surface() && ref.hasContent() && ref.isSharedMemory();
+        if (ours != m_ownNode) {
+            delete oldNode;
+            oldNode = nullptr;
+            m_ownNode = ours;
+        }
+        if (!ours)
+            return QWaylandQuickItem::updatePaintNode(oldNode, data);
+
+        QSGSimpleTextureNode* node = static_cast<QSGSimpleTextureNode*>(oldNode);
+        ShmTexture* texture;
+        if (!node) {
+            node = new QSGSimpleTextureNode;
+            texture = new ShmTexture;
+            node->setTexture(texture);
+            node->setOwnsTexture(true);
+        } else {
+            texture = static_cast<ShmTexture*>(node->texture());
+        }
+        // On the node (its material sets the texture's filtering when sampling),
+        // every sync so changes to `smooth` apply to an existing node
+        node->setFiltering(smooth() ? QSGTexture::Linear : QSGTexture::Nearest);
+
+        // A new buffer without damage still replaces the held one so it can be released
+        if (!m_damage.isEmpty() || !(texture->buffer() == ref)) {
+            // Damage arrives in surface coordinates; the viewport may scale the buffer
+            QSize destination = surface()->destinationSize();
+            qreal sx = destination.width() > 0 ? qreal(ref.size().width()) / destination.width() : 1;
+            qreal sy = destination.height() > 0 ? qreal(ref.size().height()) / destination.height() : 1;
+            QRegion bufferDamage;
+            for (const QRect& rect : m_damage)
+                bufferDamage += QRectF(rect.x() * sx, rect.y() * sy, rect.width() * sx, rect.height() * sy).toAlignedRect();
+            texture->setBuffer(ref, bufferDamage);
+            node->markDirty(QSGNode::DirtyMaterial);
+            m_damage = QRegion();
+        }
+
+        node->setRect(boundingRect());
+        node->setSourceRect(surface()->sourceGeometry().isValid()
+                            ? surface()->sourceGeometry() : QRectF(QPointF(), ref.size()));
+        return node;
+    }
+
+private:
+    void trackSurface() {
+        disconnect(m_damageConnection);
+        if (!surface())
+            return;
+        m_damageConnection = connect(surface(), &QWaylandSurface::damaged, this, [this](const QRegion& region) {
+            m_damage += region;
+        });
+        // No damage seed: the first buffer (and any resize) is uploaded whole
+        // because ShmTexture::setBuffer sees a new size
+        m_damage = QRegion();
+    }
+
+    // Frame time runs from sync to the end of rendering; swap and the vsync
+    // wait after it are not the compositor's cost
+    void trackWindow(QQuickWindow* window) {
+        disconnect(m_frameStartConnection);
+        disconnect(m_frameEndConnection);
+        if (!window)
+            return;
+        m_frameStartConnection = connect(window, &QQuickWindow::beforeSynchronizing, this, [this]() {
+            m_frameTimer.start();
+        }, Qt::DirectConnection);
+        m_frameEndConnection = connect(window, &QQuickWindow::afterRendering, this, [this, window]() {
+            if (!m_frameTimer.isValid())
+                return;
+            double ms = m_frameTimer.nsecsElapsed() / 1e6;
+            m_frameTimer.invalidate();
+            m_frames++;
+            m_frameMs += ms;
+            m_maxFrameMs = qMax(m_maxFrameMs, ms);
+
+            if (!m_logTimer.isValid())
+                m_logTimer.start();
+            if (m_logTimer.elapsed() < 5000)
+                return;
+            qint64 uploads = uploadStats.uploads.exchange(0);
+            qint64 bytes = uploadStats.bytes.exchange(0);
+            qint64 fullBytes = uploadStats.fullBytes.exchange(0);
+            QSize size = window->size() * window->devicePixelRatio();
+            if (m_importedBuffers) {
+                qDebug("compositor %dx%d: %lld frames, client buffers imported without upload, frame time avg %.2f ms max %.2f ms",
+                       size.width(), size.height(), m_frames, m_frameMs / m_frames, m_maxFrameMs);
+            } else if (m_fullUpload) {
+                qDebug("compositor %dx%d: %lld frames, stock full upload per commit, frame time avg %.2f ms max %.2f ms",
+                       size.width(), size.height(), m_frames, m_frameMs / m_frames, m_maxFrameMs);
+            } else {
+                qDebug("compositor %dx%d: %lld frames, %lld uploads, %.2f MB/upload (full buffer %.2f MB), frame time avg %.2f ms max %.2f ms",
+                       size.width(), size.height(), m_frames, uploads,
+                       uploads ? bytes / 1e6 / uploads : 0.0, uploads ? fullBytes / 1e6 / uploads : 0.0,
+                       m_frameMs / m_frames, m_maxFrameMs);
+            }
+            m_frames = 0;
+            m_frameMs = m_maxFrameMs = 0;
+            m_logTimer.restart();
+        }, Qt::DirectConnection);
+    }
+
+    bool m_fullUpload;
+    bool m_ownNode = false;
+    bool m_importedBuffers = false;  // dmabuf/EGL buffers, which the hardware integration imports
+    QRegion m_damage;
+    QMetaObject::Connection m_damageConnection;
+    QMetaObject::Connection m_frameStartConnection;
+    QMetaObject::Connection m_frameEndConnection;
+
+    // Render thread
+    QElapsedTimer m_frameTimer;
+    QElapsedTimer m_logTimer;
+    qint64 m_frames = 0;
+    double m_frameMs = 0;
+    double m_maxFrameMs = 0;
+};
+
 class MpvLauncher : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(QString socketName READ socketName CONSTANT)
     Q_PROPERTY(QString videoFile READ videoFile CONSTANT)
+    Q_PROPERTY(QVariantMap observed READ observed NOTIFY observedChanged)
 
 public:
     MpvLauncher(const QString& socket, const QString& video, QObject* parent = nullptr)
         : QObject(parent), m_socketName(socket), m_videoFile(video), m_process(nullptr), m_ipcSocket(nullptr), m_stopped(false)
     {
         m_ipcPath = QString("/tmp/mpv-ipc-%1.sock").arg(QCoreApplication::applicationPid());
+
+        // A cheap probe every second keeps round-trip samples coming while
+        // nothing else is sent; the stats are logged every 5 s
+        m_probeTimer.setInterval(1000);
+        connect(&m_probeTimer, &QTimer::timeout, this, [this]() {
+            command({"get_property", "pid"});
+        });
+        m_rttLogTimer.setInterval(5000);
+        connect(&m_rttLogTimer, &QTimer::timeout, this, &MpvLauncher::logRoundTrips);
     }
 
+    typedef std::function<void(const QJsonObject&)> ReplyHandler;
+
     ~MpvLauncher() override {
         stop();
     }
 
     QString socketName() const { return m_socketName; }
     QString videoFile() const { return m_videoFile; }
+    QVariantMap observed() const { return m_observed; }
 
-    Q_INVOKABLE void start() {
+    Q_INVOKABLE void start(int width, int height) {
         if (m_process) return;
 
         m_process = new QProcess(this);
@@ -108,28 +605,47 @@ public:
         env.insert("WAYLAND_DISPLAY", m_socketName);
         m_process->setProcessEnvironment(env);
 
-        QStringList args = {
-            "--vo=wlshm",
-            "--vf=format=fmt=bgr0",
+        // MPV_OVERLAY_VO=dmabuf-wayland or gpu hands the compositor dmabufs
+        // that are imported as textures; wlshm is the CPU-copy fallback
+        QString vo = qEnvironmentVariable("MPV_OVERLAY_VO", "wlshm");
+        // Profile first: later arguments win, so it can't override the output
+        QStringList args = activeMpvProfile().toArguments();
+        if (vo == "dmabuf-wayland") {
+            args << "--vo=dmabuf-wayland";
+        } else if (vo == "gpu") {
+            args << "--vo=gpu" << "--gpu-context=wayland";
+        } else {
+            if (vo != "wlshm")
+                qWarning("Unknown MPV_OVERLAY_VO '%s', using wlshm", qPrintable(vo));
+            vo = "wlshm";
+            args << "--vo=wlshm" << "--vf=format=fmt=bgr0";
+        }
+        args << QStringList{
             "--force-window=yes",
             "--no-border",
-            "--geometry=1280x720",
+            QString("--geometry=%1x%2").arg(width).arg(height),
             QString("--input-ipc-server=%1").arg(m_ipcPath),
-            m_videoFile
         };
+        args << m_videoFile;
+        fprintf(stderr, "mpv output: --vo=%s\n", qPrintable(vo));
 
         connect(m_process, &QProcess::finished, this, [](int exitCode) {
             QCoreApplication::exit(exitCode);
         });
         m_process->start("mpv", args);
-        QTimer::singleShot(500, this, &MpvLauncher::connectIpc);
+        m_ipcTimer.start();
+        watchIpc();
     }
 
     Q_INVOKABLE void stop() {
         if (m_stopped) return;
         m_stopped = true;
+        m_probeTimer.stop();
+        m_rttLogTimer.stop();
         // Send quit command via IPC
-        sendCommand({"quit"});
+        command({"quit"});
+        delete m_ipcWatcher;
+        m_ipcWatcher = nullptr;
         if (m_ipcSocket) {
             m_ipcSocket->flush();
             m_ipcSocket->disconnectFromServer();
@@ -147,29 +663,133 @@ public:
         QFile::remove(m_ipcPath);
     }
 
-    Q_INVOKABLE void resize(int width, int height) {
-        sendCommand({"set_property", "geometry", QString("%1x%2").arg(width).arg(height)});
+    // Streams a property into `observed`
+    Q_INVOKABLE void observe(const QString& property) {
+        if (m_observeIds.contains(property)) return;
+        int id = m_observeIds.size() + 1;
+        m_observeIds.insert(property, id);
+        command({"observe_property", id, property});
     }
 
+    // Pipelined: each command carries a request_id and `onReply` gets mpv's
+    // reply ({"error": ..., "data": ...}) whenever it arrives. Commands issued
+    // before the socket is connected go out as soon as it is.
+    void command(const QVariantList& command, ReplyHandler onReply = ReplyHandler()) {
+        if (m_stopped && command.value(0).toString() != "quit") return;
+        qint64 id = m_nextRequestId++;
+        QJsonObject msg;
+        msg["command"] = QJsonArray::fromVariantList(command);
+        msg["request_id"] = id;
+        m_replies[id].handler = onReply;
+        m_replies[id].name = command.value(0).toString();
+        m_queued.append(qMakePair(id, QJsonDocument(msg).toJson(QJsonDocument::Compact) + "\n"));
+        writeQueued();
+    }
+
+Q_SIGNALS:
+    void observedChanged();
+
 private:
-    void connectIpc() {
-        if (m_stopped) return;
-        if (m_ipcSocket) delete m_ipcSocket;
+    struct PendingReply
+    {
+        ReplyHandler handler;
+        QString name;
+        QElapsedTimer sent;
+    };
+
+    // Connects as soon as mpv creates its socket, without blocking the GUI thread
+    void watchIpc() {
         m_ipcSocket = new QLocalSocket(this);
+        connect(m_ipcSocket, &QLocalSocket::connected, this, [this]() {
+            qDebug("mpv IPC connected %lld ms after launch", m_ipcTimer.elapsed());
+            delete m_ipcWatcher;
+            m_ipcWatcher = nullptr;
+            writeQueued();
+            m_probeTimer.start();
+            m_rttLogTimer.start();
+        });
+        connect(m_ipcSocket, &QLocalSocket::errorOccurred, this, [this](QLocalSocket::LocalSocketError error) {
+            // The socket file can exist a moment before mpv listens on it
+            if (!m_stopped && m_ipcWatcher && error != QLocalSocket::PeerClosedError)
+                QTimer::singleShot(10, this, &MpvLauncher::connectIpc);
+        });
+        connect(m_ipcSocket, &QLocalSocket::readyRead, this, &MpvLauncher::readIpc);
+
+        m_ipcWatcher = new QFileSystemWatcher({QFileInfo(m_ipcPath).absolutePath()}, this);
+        connect(m_ipcWatcher, &QFileSystemWatcher::directoryChanged, this, &MpvLauncher::connectIpc);
+        connectIpc();
+    }
+
+    void connectIpc() {
+        if (m_stopped || !m_ipcSocket || m_ipcSocket->state() != QLocalSocket::UnconnectedState) return;
+        if (!QFileInfo::exists(m_ipcPath)) return;
         m_ipcSocket->connectToServer(m_ipcPath);
-        if (!m_ipcSocket->waitForConnected(2000)) {
-            if (!m_stopped) {
-                QTimer::singleShot(500, this, &MpvLauncher::connectIpc);
+    }
+
+    void writeQueued() {
+        if (!m_ipcSocket || m_ipcSocket->state() != QLocalSocket::ConnectedState) return;
+        for (const auto& queued : m_queued) {
+            m_replies[queued.first].sent.start();
+            m_ipcSocket->write(queued.second);
+        }
+        m_queued.clear();
+    }
+
+    // Newline-delimited JSON; a partial line waits in m_readBuffer for the rest
+    void readIpc() {
+        m_readBuffer += m_ipcSocket->readAll();
+        qsizetype start = 0;
+        qsizetype end;
+        while ((end = m_readBuffer.indexOf('\n', start)) >= 0) {
+            QByteArray line = m_readBuffer.mid(start, end - start);
+            start = end + 1;
+            QJsonParseError error;
+            QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+            if (!doc.isObject()) {
+                qWarning("mpv IPC: unparseable line (%s): %s",
+                         qPrintable(error.errorString()), line.left(200).constData());
+                continue;
             }
+            QJsonObject msg = doc.object();
+            if (msg.contains("request_id"))
+                handleReply(msg);
+            else if (msg.value("event").toString() == "property-change")
+                handlePropertyChange(msg);
         }
+        m_readBuffer.remove(0, start);
     }
 
-    void sendCommand(const QVariantList& command) {
-        if (!m_ipcSocket || m_ipcSocket->state() != QLocalSocket::ConnectedState) return;
-        QJsonObject msg;
-        msg["command"] = QJsonArray::fromVariantList(command);
-        m_ipcSocket->write(QJsonDocument(msg).toJson(QJsonDocument::Compact) + "\n");
-        m_ipcSocket->flush();
+    void handleReply(const QJsonObject& msg) {
+        auto it = m_replies.find(msg.value("request_id").toInteger());
+        if (it == m_replies.end()) return;
+        PendingReply reply = *it;
+        m_replies.erase(it);
+
+        double ms = reply.sent.nsecsElapsed() / 1e6;
+        m_rttCount++;
+        m_rttTotalMs += ms;
+        m_rttMaxMs = qMax(m_rttMaxMs, ms);
+
+        if (msg.value("error").toString() != "success")
+            qWarning("mpv IPC %s failed: %s", qPrintable(reply.name), qPrintable(msg.value("error").toString()));
+        if (reply.handler)
+            reply.handler(msg);
+    }
+
+    void logRoundTrips() {
+        if (m_rttCount == 0) {
+            qDebug("mpv IPC: no replies in 5 s, %lld in flight", qint64(m_replies.size()));
+            return;
+        }
+        qDebug("mpv IPC: %lld replies, round trip avg %.2f ms max %.2f ms, %lld in flight",
+               m_rttCount, m_rttTotalMs / m_rttCount, m_rttMaxMs, qint64(m_replies.size()));
+        m_rttCount = 0;
+        m_rttTotalMs = m_rttMaxMs = 0;
+    }
+
+    void handlePropertyChange(const QJsonObject& msg) {
+        m_observed[msg.value("name").toString()] = msg.value("data").toVariant();
+        emit observedChanged();
     }
 
     QString m_socketName;
@@ -177,11 +797,37 @@ private:
     QString m_ipcPath;
     QProcess* m_process;
     QLocalSocket* m_ipcSocket;
+    QFileSystemWatcher* m_ipcWatcher = nullptr;
     bool m_stopped;
+
+    qint64 m_nextRequestId = 1;
+    QList<QPair<qint64, QByteArray>> m_queued;
+    QHash<qint64, PendingReply> m_replies;
+    QByteArray m_readBuffer;
+    QHash<QString, int> m_observeIds;
+    QVariantMap m_observed;
+
+    QElapsedTimer m_ipcTimer;
+    QTimer m_probeTimer;
+    QTimer m_rttLogTimer;
+    qint64 m_rttCount = 0;
+    double m_rttTotalMs = 0;
+    double m_rttMaxMs = 0;
 };
 
 int main(int argc, char* argv[])
 {
+    activeMpvProfile() = mpvProfileFromArguments(argc, argv);
+    fprintf(stderr, "mpv profile: %s\n", activeMpvProfile().describe().constData());
+
+    // zwp_linux_dmabuf_v1 for mpv's dmabuf-wayland and gpu outputs, wl_drm for
+    // older EGL clients; shm formats are always offered alongside
+    if (!qEnvironmentVariableIsSet("QT_WAYLAND_HARDWARE_INTEGRATION"))
+        qputenv("QT_WAYLAND_HARDWARE_INTEGRATION", "linux-dmabuf-unstable-v1;wayland-egl");
+    fprintf(stderr, "client buffer integrations: %s\n", qgetenv("QT_WAYLAND_HARDWARE_INTEGRATION").constData());
+    // Client buffers are imported as EGLImages, so the scene graph must be on OpenGL
+    QQuickWindow::setGraphicsApi(QSGRendererInterface::OpenGL);
+
     QtWebEngineQuick::initialize();
 
     QGuiApplication app(argc, argv);
@@ -196,12 +842,19 @@ int main(int argc, char* argv[])
 
     MpvLauncher launcher(socketName, videoFile);
     InputForwarder inputForwarder;
+    ToplevelSizer toplevelSizer;
     ViewporterHelper viewporterHelper;
 
     QQmlApplicationEngine engine;
     engine.rootContext()->setContextProperty("mpvLauncher", &launcher);
     engine.rootContext()->setContextProperty("inputForwarder", &inputForwarder);
     engine.rootContext()->setContextProperty("viewporterHelper", &viewporterHelper);
+    engine.rootContext()->setContextProperty("toplevelSizer", &toplevelSizer);
+    engine.rootContext()->setContextProperty("resizeStorm", qEnvironmentVariableIntValue("MPV_OVERLAY_RESIZE_STORM") != 0);
+    // Offscreen layers cost two extra passes per frame and are only kept for comparison
+    engine.rootContext()->setContextProperty("layersEnabled", qEnvironmentVariableIntValue("MPV_OVERLAY_LAYERS") != 0);
+    engine.rootContext()->setContextProperty("benchmark4k", qEnvironmentVariableIntValue("MPV_OVERLAY_4K") != 0);
+    qmlRegisterType<DamageSurfaceItem>("Example.Compositor", 1, 0, "DamageSurfaceItem");
     engine.loadFromModule("Example", "Main");
 
     return app.exec();
@@ -13,8 +13,9 @@ ApplicationWindow {
     title: "mpv with Qt WebEngine Overlay (Qt6 OpenGL)"
     color: "#000000"
 
-    // MpvItem - handles video rendering
-    MpvItem {
+    // Video: MpvItem (mpv renders into an FBO the scene graph textures), or
+    // MpvDirectItem (mpv draws straight into the window, MPV_OVERLAY_DIRECT=1)
+    Loader {
         id: mpv
         objectName: "mpv"
 
@@ -24,12 +25,48 @@ ApplicationWindow {
         anchors.right: mainWindow.contentItem.right
         anchors.top: mainWindow.contentItem.top
 
-        onReady: {
-            console.log("MPV ready, loading:", videoFile)
-            commandAsync(["loadfile", videoFile])
+        sourceComponent: directRendering ? directVideo : fboVideo
+    }
+
+    Component {
+        id: fboVideo
+        MpvItem {
+            onReady: {
+                console.log("MPV ready, loading:", videoFile)
+                // Throttled, batched updates for the stats line below
+                observe("time-pos", 4)
+                observe("paused-for-cache")
+                observe("frame-drop-count", 1)
+                commandAsync(["loadfile", videoFile])
+            }
+        }
+    }
+
+    Component {
+        id: directVideo
+        MpvDirectItem {
+            onReady: {
+                console.log("MPV ready (direct), loading:", videoFile)
+                commandAsync(["loadfile", videoFile])
+            }
         }
     }
 
+    // Playback stats from MpvItem's batched property updates
+    Text {
+        readonly property var observed: mpv.item && mpv.item.observed ? mpv.item.observed : ({})
+        anchors.left: mpv.left
+        anchors.bottom: mpv.bottom
+        anchors.margins: 8
+        z: 101
+        visible: !directRendering
+        color: "#cccccc"
+        font.pixelSize: 12
+        text: "time " + Number(observed["time-pos"] || 0).toFixed(1) + "s"
+              + "  drops " + (observed["frame-drop-count"] || 0)
+              + (observed["paused-for-cache"] ? "  buffering" : "")
+    }
+
     // WebEngineView overlays on top of MPV video
     // Key technique: transparent background + z-index positioning
     WebEngineView {
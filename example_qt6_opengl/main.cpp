@@ -2,12 +2,101 @@
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include <QQuickWindow>
+#include <QElapsedTimer>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
 #include <QtWebEngineQuick/QtWebEngineQuick>
 
+#include "mpvprofile.h"
+
 #include <cstdio>
+#include <memory>
+
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+
+// GPU time of each scene-graph frame from a pair of GL_TIMESTAMP counters, read
+// back a few frames later so nothing stalls. Counters rather than a
+// GL_TIME_ELAPSED query, which can't nest with mpv's own timer queries.
+// Render thread only.
+struct FrameGpuTimer
+{
+    static const int QueryCount = 4;
+    typedef void (QOPENGLF_APIENTRYP QueryCounter)(GLuint, GLenum);
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectui64v)(GLuint, GLenum, quint64 *);
+
+    GLuint queries[QueryCount][2] = {};
+    bool pending[QueryCount] = {};
+    int next = 0;
+    bool active = false;
+    bool initialized = false;
+    QueryCounter queryCounter = nullptr;
+    GetQueryObjectui64v getQueryObjectui64v = nullptr;
+
+    QElapsedTimer interval;
+    qint64 frames = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+
+    void begin()
+    {
+        QOpenGLContext *context = QOpenGLContext::currentContext();
+        if (!initialized) {
+            initialized = true;
+            bool timerQueries = context->hasExtension("GL_ARB_timer_query")
+                             || context->hasExtension("GL_EXT_disjoint_timer_query")
+                             || (!context->isOpenGLES() && context->format().version() >= qMakePair(3, 3));
+            bool es = context->isOpenGLES();
+            queryCounter = reinterpret_cast<QueryCounter>(
+                context->getProcAddress(es ? "glQueryCounterEXT" : "glQueryCounter"));
+            getQueryObjectui64v = reinterpret_cast<GetQueryObjectui64v>(
+                context->getProcAddress(es ? "glGetQueryObjectui64vEXT" : "glGetQueryObjectui64v"));
+            if (!timerQueries || !queryCounter || !getQueryObjectui64v) {
+                qWarning("GL timer queries unavailable; no GPU frame times");
+                queryCounter = nullptr;
+                return;
+            }
+            context->extraFunctions()->glGenQueries(QueryCount * 2, queries[0]);
+            interval.start();
+        }
+        if (!queryCounter)
+            return;
+
+        if (pending[next]) {
+            GLuint available = 0;
+            context->extraFunctions()->glGetQueryObjectuiv(queries[next][1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return;
+            quint64 startNs = 0, endNs = 0;
+            getQueryObjectui64v(queries[next][0], GL_QUERY_RESULT, &startNs);
+            getQueryObjectui64v(queries[next][1], GL_QUERY_RESULT, &endNs);
+            pending[next] = false;
+            double ms = (endNs - startNs) / 1e6;
+            totalMs += ms;
+            maxMs = qMax(maxMs, ms);
+            frames++;
+        }
+        queryCounter(queries[next][0], GL_TIMESTAMP);
+        active = true;
+    }
+
+    void end()
+    {
+        if (!active)
+            return;
+        queryCounter(queries[next][1], GL_TIMESTAMP);
+        active = false;
+        pending[next] = true;
+        next = (next + 1) % QueryCount;
+    }
+};
 
 int main(int argc, char* argv[])
 {
+    activeMpvProfile() = mpvProfileFromArguments(argc, argv);
+    qDebug() << "mpv profile:" << activeMpvProfile().describe().constData();
+
     // Must initialize QtWebEngine before QGuiApplication
     QtWebEngineQuick::initialize();
 
@@ -20,6 +109,9 @@ int main(int argc, char* argv[])
 
     QString videoFile = QString::fromUtf8(argv[1]);
 
+    // MPV_OVERLAY_DIRECT=1 renders mpv straight into the window (MpvDirectItem)
+    bool directRendering = qEnvironmentVariableIntValue("MPV_OVERLAY_DIRECT") != 0;
+
     // Required by mpv
     QQuickWindow::setGraphicsApi(QSGRendererInterface::OpenGL);
 
@@ -28,6 +120,43 @@ int main(int argc, char* argv[])
 
     // Pass video file to QML
     engine.rootContext()->setContextProperty("videoFile", videoFile);
+    engine.rootContext()->setContextProperty("directRendering", directRendering);
+
+    // Benchmark: GPU time per frame and what the intermediate FBO costs;
+    // MPV_OVERLAY_4K=1 sizes the window to 3840x2160
+    QObject::connect(&engine, &QQmlApplicationEngine::objectCreated, [directRendering](QObject *obj, const QUrl &) {
+        QQuickWindow *window = qobject_cast<QQuickWindow *>(obj);
+        if (!window)
+            return;
+        if (qEnvironmentVariableIntValue("MPV_OVERLAY_4K"))
+            window->resize(3840, 2160);
+
+        auto timer = std::make_shared<FrameGpuTimer>();
+        QObject::connect(window, &QQuickWindow::beforeRendering, window, [window, timer]() {
+            window->beginExternalCommands();
+            timer->begin();
+            window->endExternalCommands();
+        }, Qt::DirectConnection);
+        QObject::connect(window, &QQuickWindow::afterRendering, window, [window, timer, directRendering]() {
+            window->beginExternalCommands();
+            timer->end();
+            window->endExternalCommands();
+
+            if (timer->frames == 0 || timer->interval.elapsed() < 5000)
+                return;
+            QSize size = window->size() * window->devicePixelRatio();
+            // Not measured: computed from the size. FBO mode has one extra RGBA8
+            // window-sized buffer, written by mpv and read back by the scene graph
+            double fboMb = directRendering ? 0 : size.width() * size.height() * 4 / 1e6;
+            qDebug("%s: %dx%d, GPU frame avg %.2f ms max %.2f ms (measured); intermediate FBO %.1f MB, "
+                   "extra traffic %.1f MB/frame (estimated from size, not measured)",
+                   directRendering ? "direct" : "fbo", size.width(), size.height(),
+                   timer->totalMs / timer->frames, timer->maxMs, fboMb, fboMb * 2);
+            timer->frames = 0;
+            timer->totalMs = timer->maxMs = 0;
+            timer->interval.restart();
+        }, Qt::DirectConnection);
+    });
 
     // Load QML from module
     engine.loadFromModule("Example", "Main");
@@ -0,0 +1,164 @@
+#include "mpvdirectitem.h"
+#include "mpvprofile.h"
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QQuickWindow>
+#include <QVector>
+
+#include <clocale>
+
+static void *get_proc_address(void *ctx, const char *name)
+{
+    Q_UNUSED(ctx);
+    QOpenGLContext *glctx = QOpenGLContext::currentContext();
+    return glctx ? (void *)glctx->getProcAddress(QByteArray(name)) : nullptr;
+}
+
+MpvDirectItem::MpvDirectItem(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    // mpv requires C locale
+    setlocale(LC_NUMERIC, "C");
+
+    m_mpv = mpv_create();
+    if (!m_mpv)
+        qFatal("Failed to create mpv instance");
+
+    mpv_set_option_string(m_mpv, "terminal", "yes");
+
+    // Log level, caches, decoder threads, scaler etc. come from the profile
+    for (const MpvProfile::Option &option : activeMpvProfile().options)
+        mpv_set_option_string(m_mpv, option.first.constData(), option.second.constData());
+
+    // Critical: Set vo=libmpv for Qt integration, after the profile so it wins
+    mpv_set_option_string(m_mpv, "vo", "libmpv");
+
+    if (mpv_initialize(m_mpv) < 0)
+        qFatal("Failed to initialize mpv");
+    mpv_set_wakeup_callback(m_mpv, onMpvWakeup, this);
+
+    connect(this, &QQuickItem::windowChanged, this, &MpvDirectItem::onWindowChanged);
+}
+
+MpvDirectItem::~MpvDirectItem()
+{
+    if (m_renderContext)
+        mpv_render_context_set_update_callback(m_renderContext, nullptr, nullptr);
+    mpv_set_wakeup_callback(m_mpv, nullptr, nullptr);
+    mpv_terminate_destroy(m_mpv);
+}
+
+void MpvDirectItem::commandAsync(const QStringList &params)
+{
+    QList<QByteArray> utf8;
+    for (const QString &param : params)
+        utf8.append(param.toUtf8());
+    QVector<const char *> args;
+    for (const QByteArray &arg : utf8)
+        args.append(arg.constData());
+    args.append(nullptr);
+    mpv_command_async(m_mpv, 0, args.data());
+}
+
+void MpvDirectItem::onWindowChanged(QQuickWindow *window)
+{
+    if (m_window)
+        disconnect(m_window, nullptr, this, nullptr);
+    m_window = window;
+    if (!window)
+        return;
+    connect(window, &QQuickWindow::beforeRenderPassRecording, this, &MpvDirectItem::renderVideo, Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, &MpvDirectItem::reportSwap, Qt::DirectConnection);
+    connect(window, &QQuickWindow::sceneGraphInvalidated, this, &MpvDirectItem::releaseRenderer, Qt::DirectConnection);
+}
+
+void MpvDirectItem::renderVideo()
+{
+    QQuickWindow *win = window();
+    if (!win)
+        return;
+
+    // Raw GL inside Qt's render pass, right after the clear and before any item
+    win->beginExternalCommands();
+
+    if (!m_renderContext) {
+        mpv_opengl_init_params glParams = {get_proc_address, nullptr};
+        mpv_render_param params[] = {
+            {MPV_RENDER_PARAM_API_TYPE, (void *)MPV_RENDER_API_TYPE_OPENGL},
+            {MPV_RENDER_PARAM_OPENGL_INIT_PARAMS, &glParams},
+            {MPV_RENDER_PARAM_INVALID, nullptr}
+        };
+        if (mpv_render_context_create(&m_renderContext, m_mpv, params) < 0)
+            qFatal("Failed to create mpv render context");
+        mpv_render_context_set_update_callback(m_renderContext, onMpvUpdate, this);
+        // Only the first context: a context recreated after sceneGraphInvalidated
+        // must not restart playback
+        if (!m_readyEmitted) {
+            m_readyEmitted = true;
+            QMetaObject::invokeMethod(this, &MpvDirectItem::ready, Qt::QueuedConnection);
+        }
+    }
+
+    m_updatePending = false;
+    mpv_render_context_update(m_renderContext);
+
+    GLint fbo = 0;
+    QOpenGLContext::currentContext()->functions()->glGetIntegerv(GL_FRAMEBUFFER_BINDING, &fbo);
+    QSize size = win->size() * win->devicePixelRatio();
+    mpv_opengl_fbo mpvFbo = {int(fbo), size.width(), size.height(), 0};
+    int flip = 1;
+    mpv_render_param params[] = {
+        {MPV_RENDER_PARAM_OPENGL_FBO, &mpvFbo},
+        {MPV_RENDER_PARAM_FLIP_Y, &flip},
+        {MPV_RENDER_PARAM_INVALID, nullptr}
+    };
+    mpv_render_context_render(m_renderContext, params);
+    m_rendered = true;
+
+    win->endExternalCommands();
+}
+
+void MpvDirectItem::reportSwap()
+{
+    if (m_renderContext && m_rendered)
+        mpv_render_context_report_swap(m_renderContext);
+    m_rendered = false;
+}
+
+void MpvDirectItem::releaseRenderer()
+{
+    if (m_renderContext)
+        mpv_render_context_free(m_renderContext);
+    m_renderContext = nullptr;
+}
+
+// mpv's thread: one queued repaint until the next render picks it up
+void MpvDirectItem::onMpvUpdate(void *ctx)
+{
+    MpvDirectItem *self = static_cast<MpvDirectItem *>(ctx);
+    if (!self->m_updatePending.exchange(true))
+        QMetaObject::invokeMethod(self, [self]() {
+            if (self->window())
+                self->window()->update();
+        }, Qt::QueuedConnection);
+}
+
+void MpvDirectItem::onMpvWakeup(void *ctx)
+{
+    MpvDirectItem *self = static_cast<MpvDirectItem *>(ctx);
+    if (!self->m_eventsPending.exchange(true))
+        QMetaObject::invokeMethod(self, &MpvDirectItem::handleEvents, Qt::QueuedConnection);
+}
+
+void MpvDirectItem::handleEvents()
+{
+    m_eventsPending = false;
+    while (true) {
+        mpv_event *event = mpv_wait_event(m_mpv, 0);
+        if (event->event_id == MPV_EVENT_NONE)
+            break;
+        if (event->event_id == MPV_EVENT_COMMAND_REPLY && event->error < 0)
+            qWarning() << "mpv command failed:" << mpv_error_string(event->error);
+    }
+}
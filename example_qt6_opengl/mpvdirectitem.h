@@ -0,0 +1,50 @@
+#ifndef MPVDIRECTITEM_H
+#define MPVDIRECTITEM_H
+
+#include <QQuickItem>
+#include <QStringList>
+
+#include <mpv/client.h>
+#include <mpv/render_gl.h>
+
+#include <atomic>
+
+// Alternative to MpvItem: mpv draws straight into the window's render target
+// from beforeRenderPassRecording, underneath the rest of the scene, instead of
+// into an item-owned FBO that the scene graph then textures. Like the Qt5
+// example, it covers the whole window.
+class MpvDirectItem : public QQuickItem
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+public:
+    explicit MpvDirectItem(QQuickItem *parent = nullptr);
+    ~MpvDirectItem() override;
+
+    Q_INVOKABLE void commandAsync(const QStringList &params);
+
+Q_SIGNALS:
+    // First render context exists; safe to load files. Emitted once
+    void ready();
+
+private:
+    void onWindowChanged(QQuickWindow *window);
+    void renderVideo();     // render thread
+    void reportSwap();      // render thread
+    void releaseRenderer(); // render thread
+    void handleEvents();
+
+    static void onMpvUpdate(void *ctx);
+    static void onMpvWakeup(void *ctx);
+
+    mpv_handle *m_mpv = nullptr;
+    mpv_render_context *m_renderContext = nullptr;
+    QQuickWindow *m_window = nullptr;
+    std::atomic<bool> m_updatePending{false};
+    std::atomic<bool> m_eventsPending{false};
+    bool m_rendered = false;
+    bool m_readyEmitted = false; // render thread
+};
+
+#endif // MPVDIRECTITEM_H
@@ -1,12 +1,29 @@
 #include "mpvitem.h"
+#include "mpvprofile.h"
+
+#include <MpvController>
 
 MpvItem::MpvItem(QQuickItem *parent)
     : MpvAbstractItem(parent)
+    , m_properties(this, [this](const QVariantMap &changes) { Q_EMIT propertiesUpdated(changes); })
 {
-    // Critical: Set vo=libmpv for Qt integration
+    Q_EMIT setProperty("terminal", "yes");
+
+    // Log level, caches, decoder threads, scaler etc. come from the profile
+    for (const MpvProfile::Option &option : activeMpvProfile().options)
+        Q_EMIT setProperty(QString::fromUtf8(option.first), QString::fromUtf8(option.second));
+
+    // Critical: Set vo=libmpv for Qt integration, after the profile so it wins
     Q_EMIT setProperty("vo", "libmpv");
 
-    // Verbose logging
-    Q_EMIT setProperty("terminal", "yes");
-    Q_EMIT setProperty("msg-level", "all=v");
+    // Property changes are coalesced on mpv's event thread and flushed in batches
+    connect(mpvController(), &MpvController::propertyChanged, this,
+            [this](const QString &property, const QVariant &value) { m_properties.propertyChanged(property, value); },
+            Qt::DirectConnection);
+}
+
+void MpvItem::observe(const QString &property, qreal maxRate)
+{
+    if (m_properties.observe(property, maxRate))
+        Q_EMIT observeProperty(property, MPV_FORMAT_NODE);
 }
@@ -3,13 +3,33 @@
 
 #include <MpvAbstractItem>
 
+#include <QVariantMap>
+
+#include "mpvpropertybatcher.h"
+
 class MpvItem : public MpvAbstractItem
 {
     Q_OBJECT
     QML_ELEMENT
+    Q_PROPERTY(QVariantMap observed READ observed NOTIFY propertiesUpdated)
 
 public:
     explicit MpvItem(QQuickItem *parent = nullptr);
+
+    // Observe an mpv property; its changes reach QML at most maxRate times a
+    // second (0 = every GUI frame), batched with all other observed changes.
+    // Observing it again only changes the rate
+    Q_INVOKABLE void observe(const QString &property, qreal maxRate = 0);
+
+    // Latest delivered value of every observed property
+    QVariantMap observed() const { return m_properties.observed(); }
+
+Q_SIGNALS:
+    // At most once per GUI frame, with every property that changed since the last one
+    void propertiesUpdated(const QVariantMap &changes);
+
+private:
+    MpvPropertyBatcher m_properties;
 };
 
 #endif // MPVITEM_H
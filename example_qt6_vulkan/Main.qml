@@ -26,10 +26,27 @@ ApplicationWindow {
 
         onReady: {
             console.log("MPV ready, loading:", videoFile)
+            // Throttled, batched updates for the stats line below
+            observe("time-pos", 4)
+            observe("paused-for-cache")
+            observe("frame-drop-count", 1)
             commandAsync(["loadfile", videoFile])
         }
     }
 
+    // Playback stats from MpvItem's batched property updates
+    Text {
+        anchors.left: mpv.left
+        anchors.bottom: mpv.bottom
+        anchors.margins: 8
+        z: 101
+        color: "#cccccc"
+        font.pixelSize: 12
+        text: "time " + Number(mpv.observed["time-pos"] || 0).toFixed(1) + "s"
+              + "  drops " + (mpv.observed["frame-drop-count"] || 0)
+              + (mpv.observed["paused-for-cache"] ? "  buffering" : "")
+    }
+
     // WebEngineView overlays on top of MPV video
     // Key technique: transparent background + z-index positioning
     WebEngineView {
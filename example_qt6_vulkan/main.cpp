@@ -3,16 +3,68 @@
 #include <QQmlContext>
 #include <QQuickWindow>
 #include <QQuickGraphicsDevice>
+#include <QQuickGraphicsConfiguration>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QStandardPaths>
 #include <QVulkanInstance>
 #include <QVulkanFunctions>
 #include <QtWebEngineQuick/QtWebEngineQuick>
 
+#include "mpvitem.h"
+#include "mpvprofile.h"
+
 #include <vulkan/vulkan.h>
+#include <atomic>
 #include <cstdio>
 #include <vector>
 
+// Pipeline/shader cache directory for this device and driver. A driver update
+// gets a fresh directory and the stale one for the same device is removed;
+// other GPUs' caches are left alone.
+static QString pipelineCacheDir(QVulkanInstance &instance, VkPhysicalDevice physicalDevice)
+{
+    auto vkGetPhysicalDeviceProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2>(
+        instance.getInstanceProcAddr("vkGetPhysicalDeviceProperties2"));
+    if (!vkGetPhysicalDeviceProperties2)
+        return QString();
+
+    VkPhysicalDeviceIDProperties idProperties{};
+    idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &idProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+    QString device = QString::fromLatin1(QByteArray((const char *)idProperties.deviceUUID, VK_UUID_SIZE).toHex());
+    QString name = device + "-" + QString::number(properties.properties.driverVersion, 16);
+
+    QDir base(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/vulkan");
+    for (const QString &entry : base.entryList({device + "-*"}, QDir::Dirs)) {
+        if (entry != name) {
+            qDebug() << "Removing stale pipeline cache" << entry;
+            QDir(base.filePath(entry)).removeRecursively();
+        }
+    }
+
+    // MPV_OVERLAY_COLD_CACHE=1 starts cold, for comparing against a warm launch
+    QDir dir(base.filePath(name));
+    if (qEnvironmentVariableIntValue("MPV_OVERLAY_COLD_CACHE"))
+        dir.removeRecursively();
+    if (!dir.mkpath("."))
+        return QString();
+    return dir.absolutePath();
+}
+
 int main(int argc, char* argv[])
 {
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
+    activeMpvProfile() = mpvProfileFromArguments(argc, argv);
+    qDebug() << "mpv profile:" << activeMpvProfile().describe().constData();
+
     // Must initialize QtWebEngine before QGuiApplication
     QtWebEngineQuick::initialize();
 
@@ -69,7 +121,9 @@ int main(int argc, char* argv[])
         }
     }
 
-    // Set up queue creation info
+    // Set up queue creation info. mpv records on this same queue: mpvqt's
+    // Vulkan item builds its render context from the window's device and
+    // graphics queue and has no way to take a second one.
     float queuePriority = 1.0f;
     VkDeviceQueueCreateInfo queueCreateInfo{};
     queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
@@ -135,6 +189,18 @@ int main(int argc, char* argv[])
 
     qDebug() << "Created Vulkan device with hostQueryReset enabled";
 
+    // Qt's scene-graph pipelines and mpv's shaders persist across launches
+    QString cacheDir = pipelineCacheDir(vulkanInstance, physicalDevice);
+    QString qtPipelineCache = cacheDir.isEmpty() ? QString() : cacheDir + "/qt-pipelines.bin";
+    bool warmCache = !qtPipelineCache.isEmpty() && QFileInfo::exists(qtPipelineCache);
+    if (!cacheDir.isEmpty() && QDir(cacheDir).mkpath("mpv")) {
+        activeMpvProfile().options.append(MpvProfile::Option("gpu-shader-cache-dir", QDir(cacheDir).filePath("mpv").toUtf8()));
+        qDebug() << "Pipeline cache:" << cacheDir << (warmCache ? "(warm)" : "(cold)");
+    }
+    std::atomic<bool> videoConfigured{false};
+    std::atomic<bool> firstFrameLogged{false};
+    std::atomic<bool> firstVideoFrameLogged{false};
+
     int ret;
     {
         // Create QML engine
@@ -152,6 +218,30 @@ int main(int argc, char* argv[])
                 window->setGraphicsDevice(QQuickGraphicsDevice::fromDeviceObjects(
                     physicalDevice, device, graphicsQueueFamily, 0));
                 qDebug() << "Set custom Vulkan device on window";
+
+                if (!qtPipelineCache.isEmpty()) {
+                    QQuickGraphicsConfiguration config = window->graphicsConfiguration();
+                    if (warmCache)
+                        config.setPipelineCacheLoadFile(qtPipelineCache);
+                    config.setPipelineCacheSaveFile(qtPipelineCache);
+                    window->setGraphicsConfiguration(config);
+                }
+
+                // Cold vs warm startup: first overlay frame, first frame after mpv configured video
+                if (MpvItem *mpvItem = window->findChild<MpvItem *>("mpv")) {
+                    QObject::connect(mpvItem, &MpvItem::propertiesUpdated, mpvItem, [&](const QVariantMap &changes) {
+                        if (!changes.value("video-params").toMap().isEmpty())
+                            videoConfigured = true;
+                    });
+                    mpvItem->observe("video-params");
+                }
+                QObject::connect(window, &QQuickWindow::frameSwapped, window, [&]() {
+                    const char *cache = warmCache ? "warm" : "cold";
+                    if (!firstFrameLogged.exchange(true))
+                        qDebug("First overlay frame after %lld ms (%s cache)", (long long)startupTimer.elapsed(), cache);
+                    if (videoConfigured && !firstVideoFrameLogged.exchange(true))
+                        qDebug("First video frame after %lld ms (%s cache)", (long long)startupTimer.elapsed(), cache);
+                }, Qt::DirectConnection);
             }
         });
 